@@ -1,29 +1,77 @@
 #ifndef ASTRO_H
 #define ASTRO_H
 
+#include <stddef.h>
+#include "orient.h"
+
+// Julian date of the J2000.0 epoch the catalog positions are given for
+#define ASTRO_JD_J2000 2451545.0
+
+/*
+ * Per-frame camera. Everything projection needs is computed once
+ * when the camera is set up or moved, not per projected point.
+ */
+typedef struct
+{
+    // View matrix rows: camera coords = (r.d, u.d, f.d) for direction d
+    float rx, ry, rz;
+    float ux, uy, uz;
+    float fx, fy, fz;
+
+    int w, h;
+    float fov_deg;          // horizontal
+    float focal;            // pixels, w / (2 tan(fov/2))
+    float cx, cy;           // screen center
+    float tan_half_w;       // screen half extents at unit depth
+    float tan_half_h;
+    float half_angle_deg;   // cone enclosing the screen (view axis to corner)
+
+    // Side planes of the view frustum through the eye, unit inward
+    // normals: left, right, top, bottom. d is inside iff n.d >= 0 for all.
+    float planes[4][3];
+} camera_t;
+
 // Convert RA/Dec to a unit direction vector in world space.
 // ra_hours: 0..24, dec_deg: -90..+90
 void astro_radec_to_unit(float ra_hours, float dec_deg, float *x, float *y, float *z);
 
-// Build camera basis vectors from yaw/pitch/roll degrees.
-// Produces right/up/forward vectors (each is length 1).
-void astro_camera_basis(float yaw_deg, float pitch_deg, float roll_deg,
-                        float *rx, float *ry, float *rz,
-                        float *ux, float *uy, float *uz,
-                        float *fx, float *fy, float *fz);
+// Screen constants for a w x h view with horizontal fov_deg.
+// The orientation starts at identity (looking North along +Y).
+void astro_camera_init(camera_t *cam, int w, int h, float fov_deg);
+
+// Orientation from a body -> local quaternion (see orient.h)
+void astro_camera_set_quat(camera_t *cam, quat_t q);
+
+// Orientation from an orthonormal right/up/forward basis
+void astro_camera_set_basis(camera_t *cam,
+                            float rx, float ry, float rz,
+                            float ux, float uy, float uz,
+                            float fx, float fy, float fz);
+
+// Same camera expressed in another frame: dst = transpose(m) applied to
+// src's axes, e.g. local -> equatorial with astro_equatorial_to_local_matrix.
+// dst may alias src.
+void astro_camera_rotated(const camera_t *src, const float m[9], camera_t *dst);
 
-// Project a world direction vector onto screen.
+// Project a direction onto screen.
 // Returns 1 if visible, 0 if behind, outside view.
-// fov_deg is horizontal FOV in degrees.
-int astro_project_dir(float dirx, float diry, float dirz,
-                        float rx, float ry, float rz,
-                        float ux, float uy, float uz, 
-                        float fx, float fy, float fz,
-                        int w, int h, float fov_deg, 
-                        int *outx, int *outy, float *out_depth);
+int astro_camera_project(const camera_t *cam, float dirx, float diry, float dirz,
+                         int *outx, int *outy, float *out_depth);
+
+// Batch version of astro_camera_project over SoA direction arrays.
+// Writes n screen (x, y) pairs to out_xy (2*n floats) and a 1/0
+// visibility flag per entry to out_vis. Returns the visible count.
+size_t astro_camera_project_batch(const camera_t *cam,
+                                  const float *dx, const float *dy, const float *dz, size_t n,
+                                  float *out_xy, unsigned char *out_vis);
+
+// Name of the batch kernel selected at build time ("neon", "avx", "sse2", "scalar").
+const char *astro_batch_impl(void);
 
 // NEW: time helpers + local sky conversion
 double astro_julian_date_utc(int year, int month, int day, int hour, int min, double sec);
+void astro_jd_to_calendar(double jd_utc, int *year, int *month, int *day,
+                          int *hour, int *min, double *sec);
 double astro_gmst_hours(double jd_utc);
 double astro_lst_hours(double jd_utc, double lon_deg);
 
@@ -35,4 +83,29 @@ void astro_radec_to_altaz(float ra_hours, float dec_deg,
 // NEW: Alt/Az -> local unit vector (ENU-ish)
 void astro_altaz_to_unit(float alt_deg, float az_deg, float *x, float *y, float *z);
 
+// Equatorial -> local (ENU) rotation for an observer, row-major 3x3:
+// local = m * equatorial, for vectors from astro_radec_to_unit.
+// The transpose takes local directions back to equatorial.
+void astro_equatorial_to_local_matrix(double jd_utc, double lat_deg, double lon_deg, float m[9]);
+
+// J2000 equatorial -> equatorial of date, row-major: v_date = m * v_j2000.
+// Precession (IAU 1976) and the leading nutation terms (IAU 1980, about
+// 0.5" accuracy), with the equation of the equinoxes folded in so the
+// result pairs with the mean sidereal time used above.
+void astro_epoch_matrix(double jd_utc, float m[9]);
+
+// Unit vector for a J2000 position moved along its proper motion
+// (mas/yr, RA term including cos dec) by `years`.
+void astro_radec_pm_to_unit(float ra_hours, float dec_deg,
+                            float pm_ra_mas, float pm_dec_mas, double years,
+                            float *x, float *y, float *z);
+
+// out = transpose(m) * v, i.e. local -> equatorial for the matrix above
+void astro_mat3_tmul(const float m[9], float x, float y, float z,
+                     float *ox, float *oy, float *oz);
+
+// Half angle (degrees) of the cone that encloses the whole screen,
+// i.e. the angle from the view axis to a screen corner.
+float astro_view_cone_half_angle(int w, int h, float fov_deg);
+
 #endif
\ No newline at end of file
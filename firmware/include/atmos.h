@@ -0,0 +1,51 @@
+#ifndef ATMOS_H
+#define ATMOS_H
+
+// Samples over sin(true altitude), from ATMOS_MIN_ALT_DEG up to the zenith
+#define ATMOS_TABLE 1024
+
+// Lowest true altitude tabulated. Refraction at the horizon is about
+// 34', so nothing from below about -0.6 deg reaches the sky.
+#define ATMOS_MIN_ALT_DEG (-1.0)
+
+// Used when no local readings are given
+#define ATMOS_DEFAULT_TEMP_C 10.0f
+#define ATMOS_DEFAULT_PRESSURE_HPA 1010.0f
+
+// Visual extinction at sea-level pressure, magnitudes per airmass
+#define ATMOS_K_V 0.2f
+
+/*
+ * Atmospheric refraction and extinction as tables over the sine of
+ * the true altitude, which the star pass already has as the dot
+ * product with local Up.
+ *
+ * Refraction turns a star toward the zenith; each sample stores that
+ * turn as the weights of v' = a*v + b*Up, so the lifted vector stays
+ * unit length. Extinction is stored relative to the zenith, so the
+ * magnitude cut still means the faintest star shown overhead.
+ *
+ * Tables are built once for a temperature and pressure; a lookup is
+ * an index and a linear blend, with no tan or exp per star.
+ */
+typedef struct
+{
+    float lift_a[ATMOS_TABLE + 1];
+    float lift_b[ATMOS_TABLE + 1];
+    float dmag[ATMOS_TABLE + 1];
+
+    float h_min;        // sin(ATMOS_MIN_ALT_DEG), first sample
+    float inv_step;     // samples per unit of sin(altitude)
+    float h_visible;    // lowest sin(true altitude) refracted above the horizon
+
+    float temp_c;
+    float pressure_hpa;
+} atmos_t;
+
+// returns 0 on success, -1 on failure.
+int atmos_init(atmos_t *a, float temp_c, float pressure_hpa);
+
+// Lift weights and extra magnitudes at sin(true altitude) h.
+void atmos_lookup(const atmos_t *a, float h, float *wa, float *wb, float *dmag);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef CONSTELLATIONS_H
+#define CONSTELLATIONS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "stars.h"
+#include "starcache.h"
+#include "astro.h"
+#include "atmos.h"
+#include "linebatch.h"
+
+// Line thickness in pixels
+#define CONST_LINE_WIDTH 1.0f
+
+/*
+ * Constellation stick figures.
+ *
+ * The asset names its stars (see assets/constellations.csv); names
+ * are resolved to catalog indices once at load, so drawing reads the
+ * star cache's equatorial unit vectors directly and does no catalog
+ * or coordinate work per frame.
+ *
+ * Per frame each segment is culled against the camera's frustum
+ * planes (the same ones the sky tiles are culled with) and cut at the
+ * horizon; what remains goes out as one line batch. With an
+ * atmosphere the end points get the same refraction lift as the
+ * stars, so lines still meet them near the horizon.
+ */
+typedef struct
+{
+    uint32_t *seg;          // catalog indices, two per segment
+    size_t n_seg;
+    size_t n_figures;       // constellations in the asset
+    size_t n_missing;       // segments dropped for stars not in the catalog
+
+    line_batch_t batch;
+
+    // Segments drawn by the last constellations_draw
+    size_t n_drawn;
+} constellations_t;
+
+// returns 0 on success, -1 on failure.
+int constellations_load(constellations_t *c, const star_catalog_t *cat, const char *path);
+
+// cam and local Up (zx, zy, zz) are in the equatorial frame; atm may
+// be NULL. returns 0 on success, -1 on failure.
+int constellations_draw(constellations_t *c, SDL_Renderer *ren, const star_cache_buf_t *sc,
+                        const camera_t *cam, float zx, float zy, float zz,
+                        const atmos_t *atm, SDL_Color color);
+
+void constellations_free(constellations_t *c);
+
+#endif
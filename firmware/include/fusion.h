@@ -0,0 +1,53 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include "imu.h"
+#include "orient.h"
+
+// Mahony filter gains: proportional pull toward gravity, integral bias tracking
+#define FUSION_KP 2.0f
+#define FUSION_KI 0.05f
+
+// Longest horizon fusion_predict will extrapolate over (seconds)
+#define FUSION_PREDICT_MAX_S 0.05f
+
+/*
+ * Mahony complementary filter on a quaternion.
+ *
+ * The gyro is integrated every sample; the accelerometer's gravity
+ * direction corrects pitch/roll drift and, through the integral
+ * term, the gyro bias on those axes. There is no magnetometer, so
+ * heading is relative (it starts where the device points and drifts
+ * only with residual Z bias).
+ *
+ * Sensor axes are taken to be the body axes (X right, Y along the
+ * view, Z up); change fusion.c's sensor_to_body if the board is
+ * mounted differently.
+ */
+typedef struct
+{
+    quat_t q;               // body -> local ENU
+    float kp, ki;
+    float bx, by, bz;       // integral feedback (rad/s)
+    int initialized;
+} fusion_t;
+
+void fusion_init(fusion_t *f, float kp, float ki);
+
+// One filter step: raw gyro (deg/s) and accel (g), dt in seconds.
+// The first call levels the filter straight from the accelerometer.
+void fusion_update(fusion_t *f, const imu_raw_t *raw, float dt);
+
+// Gyro rate with the filter's bias estimate removed (rad/s, body frame)
+void fusion_rate(const fusion_t *f, const imu_raw_t *raw, float *wx, float *wy, float *wz);
+
+// Attitude dt seconds after q, assuming the body rate stays constant.
+// dt is clamped to [0, FUSION_PREDICT_MAX_S].
+quat_t fusion_predict(quat_t q, float wx, float wy, float wz, float dt);
+
+// Carries the attitude across gap seconds with no samples (lost FIFO
+// packets) at raw's bias-corrected rate, without accel correction, so
+// the rotation in the gap isn't lost. Call before fusion_update(raw).
+void fusion_bridge(fusion_t *f, const imu_raw_t *raw, float gap);
+
+#endif
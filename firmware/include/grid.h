@@ -0,0 +1,83 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stddef.h>
+#include <SDL.h>
+#include "astro.h"
+#include "linebatch.h"
+
+// Angular step between sampled points along a circle
+#define GRID_STEP_DEG 2
+#define GRID_TABLE (360 / GRID_STEP_DEG)
+
+// Spacing of the alt/az and RA/Dec lines
+#define GRID_ALT_STEP_DEG 15
+#define GRID_AZ_STEP_DEG 30
+#define GRID_DEC_STEP_DEG 15
+#define GRID_RA_STEP_H 2
+
+#define GRID_MAX_CIRCLES 64
+
+// Line thickness in pixels
+#define GRID_LINE_WIDTH 1.0f
+
+/*
+ * Line layers. HORIZON and ALTAZ are in the local ENU frame and are
+ * drawn with the local camera; RADEC and EQUATOR are in the
+ * equatorial frame and are drawn with the equatorial camera.
+ */
+typedef enum
+{
+    GRID_HORIZON = 0,
+    GRID_ALTAZ,
+    GRID_RADEC,
+    GRID_EQUATOR,
+    GRID_LAYER_COUNT
+} grid_layer_t;
+
+// p(t) = c + rho * (u cos t + v sin t), t in [t0, t1] (radians)
+typedef struct
+{
+    float c[3];
+    float rho;
+    float u[3], v[3];
+    float t0, t1;
+} grid_circle_t;
+
+/*
+ * Sky grid and horizon drawn from precomputed circles.
+ *
+ * Every line is a circle (or arc) on the sphere with its frame set
+ * up once. Per frame, each circle is cut analytically to the arc
+ * inside the view cone (and above the horizon, if asked), so only
+ * points that can be on screen are generated; points along the arc
+ * come from a shared cos/sin table. Each layer is one line batch.
+ */
+typedef struct
+{
+    grid_circle_t circles[GRID_MAX_CIRCLES];
+    int first[GRID_LAYER_COUNT + 1];    // circles of layer l: [first[l], first[l+1])
+
+    float cos_t[GRID_TABLE], sin_t[GRID_TABLE];
+
+    float *pts;                 // one polyline's screen points (x, y)
+    int pts_cap;
+    line_batch_t batch;
+
+    // Counters from the last grid_draw
+    int n_arcs;
+    int n_points;
+} sky_grid_t;
+
+// returns 0 on success, -1 on failure.
+int grid_init(sky_grid_t *g);
+
+// Draws one layer through cam, which must be in the layer's frame.
+// A nonzero Up (zx, zy, zz, same frame) also cuts the lines at the
+// horizon. returns 0 on success, -1 on failure.
+int grid_draw(sky_grid_t *g, SDL_Renderer *ren, grid_layer_t layer,
+              const camera_t *cam, float zx, float zy, float zz, SDL_Color color);
+
+void grid_free(sky_grid_t *g);
+
+#endif
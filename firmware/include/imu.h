@@ -2,6 +2,7 @@
 #define IMU_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 typedef struct {
     float yaw;
@@ -9,14 +10,55 @@ typedef struct {
     float roll;
 } imu_data_t;
 
+// One sensor reading in physical units
+typedef struct {
+    float ax, ay, az;   // g
+    float gx, gy, gz;   // deg/s
+} imu_raw_t;
+
+// Most FIFO packets drained per transaction (fits the 1 KB FIFO)
+#define IMU_FIFO_MAX_BATCH 64
+
+// Sensor setup applied by imu_configure
+typedef struct {
+    int sample_rate_hz;     // output data rate (sets SMPLRT_DIV)
+    int dlpf_cfg;           // digital low-pass filter, CONFIG.DLPF_CFG 0..6
+    int use_fifo;           // queue samples on-chip, drain with imu_read_fifo
+} imu_config_t;
+
 // returns 0 on success, -1 on failure.
 int imu_init(void);
 
+// Defaults: 250 Hz, 42 Hz DLPF, FIFO on. Sized for the Pi's default
+// 100 kHz /dev/i2c-1: 12-byte packets polled at IMU_FIFO_POLL_HZ use
+// about 40% of the bus (1 kHz would need more than all of it)
+void imu_default_config(imu_config_t *cfg);
+
+// Applies cfg to an initialized IMU. returns 0 on success, -1 on failure.
+int imu_configure(const imu_config_t *cfg);
+
 // returns 0 on success, -1 on failure.
 int imu_read(imu_data_t *data);
+
+// Single burst read of accel + gyro. returns 0 on success, -1 on failure.
+int imu_read_raw(imu_raw_t *raw);
+
+// Angles from one raw sample (accel tilt, gyro Z placeholder yaw)
+void imu_raw_to_angles(const imu_raw_t *raw, imu_data_t *data);
+
+// imu_read_fifo's result when the FIFO overflowed: it was reset and the
+// queued samples are lost, so the next packet is not one period later
+#define IMU_FIFO_OVERFLOW (-2)
+
+// Drains up to max queued FIFO samples, oldest first (FIFO mode only).
+// returns the number read, -1 on failure, or IMU_FIFO_OVERFLOW.
+int imu_read_fifo(imu_raw_t *out, size_t max);
 void imu_close(void);
 
 // helper: fill angles with simulated values (always works)
 void imu_sim_step(imu_data_t *data, float dt_seconds);
 
+// restarts the simulated motion from zero (repeatable benchmark runs)
+void imu_sim_reset(void);
+
 #endif
\ No newline at end of file
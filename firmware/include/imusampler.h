@@ -0,0 +1,70 @@
+#ifndef IMUSAMPLER_H
+#define IMUSAMPLER_H
+
+#include <SDL.h>
+#include "imu.h"
+#include "fusion.h"
+
+// Ring capacity in samples (power of two): about 1 s of history at 250 Hz
+#define IMU_RING_SIZE 256
+
+// Polling rate when draining the on-chip FIFO (several samples per poll)
+#define IMU_FIFO_POLL_HZ 200
+
+// Longest FIFO overflow gap fusion is carried across (seconds); a full
+// FIFO at 250 Hz holds about 340 ms
+#define IMU_MAX_GAP_S 0.5f
+
+// One timestamped reading plus the fused orientation after it
+typedef struct
+{
+    Uint64 t;               // SDL_GetPerformanceCounter() time of the sample
+    imu_raw_t raw;
+    quat_t q;               // body -> local ENU
+    float wx, wy, wz;       // body rate, rad/s, gyro bias removed
+    imu_data_t angles;      // q as yaw/pitch/roll (diagnostics)
+} imu_sample_t;
+
+/*
+ * IMU sampler thread.
+ *
+ * Polls the sensor at a fixed rate, independent of the frame rate:
+ * one direct read per sample or, with the FIFO enabled, a batch of
+ * queued samples per poll (back-dated by the sample period from the
+ * drain time). Every sample runs one fusion step on this thread, at
+ * sensor rate. Timestamped samples go into a single-producer /
+ * single-consumer ring. Neither side ever takes a lock: the sampler
+ * owns `head`, the render thread owns `tail`. The render thread only
+ * wants the newest sample, so the sampler never waits for it: when
+ * the ring is full the oldest slot is overwritten (and counted), and
+ * a stalled frame still picks up the freshest orientation.
+ */
+typedef struct
+{
+    imu_sample_t ring[IMU_RING_SIZE];
+    SDL_atomic_t head;      // next slot to write (sampler)
+    SDL_atomic_t tail;      // next slot to read (render thread)
+
+    SDL_atomic_t quit;
+    SDL_atomic_t dropped;   // samples overwritten before the reader saw them
+    SDL_atomic_t errors;    // failed bus reads
+    SDL_atomic_t overflows; // FIFO overflows (samples lost on the chip)
+
+    imu_config_t cfg;
+    fusion_t fusion;        // sampler thread only
+    Uint64 last_t;          // time of the last published sample
+    int resync;             // FIFO was reset; bridge the gap to the next packet
+    SDL_Thread *thread;
+} imu_sampler_t;
+
+// Starts polling an IMU already set up with imu_init + imu_configure(cfg).
+// returns 0 on success, -1 on failure.
+int imusampler_start(imu_sampler_t *s, const imu_config_t *cfg);
+
+// Newest sample, skipping everything older.
+// returns 0 if there was a new sample since the last call, -1 if not.
+int imusampler_latest(imu_sampler_t *s, imu_sample_t *out);
+
+void imusampler_stop(imu_sampler_t *s);
+
+#endif
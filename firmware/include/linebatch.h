@@ -0,0 +1,41 @@
+#ifndef LINEBATCH_H
+#define LINEBATCH_H
+
+#include <stddef.h>
+#include <SDL.h>
+
+/*
+ * Collects thin lines as quads and submits them with one
+ * SDL_RenderGeometry call. Unlike SDL_RenderDrawLines, a batch can
+ * hold any number of disjoint segments and polylines.
+ *
+ * Polylines share two vertices per point, with the normal averaged
+ * across each joint, so curves have no gaps between segments.
+ */
+typedef struct
+{
+    SDL_Vertex *verts;
+    int *indices;
+    size_t n_verts, n_indices;
+    size_t vert_cap, index_cap;
+    float width;            // pixels
+} line_batch_t;
+
+// returns 0 on success, -1 on failure.
+int linebatch_init(line_batch_t *b, float width);
+
+void linebatch_begin(line_batch_t *b);
+
+// Queues one segment. Returns -1 if out of memory.
+int linebatch_segment(line_batch_t *b, float x0, float y0, float x1, float y1,
+                      SDL_Color color);
+
+// Queues a polyline of n points (xy interleaved). Returns -1 if out of memory.
+int linebatch_strip(line_batch_t *b, const float *xy, int n, SDL_Color color);
+
+// Draws everything queued since linebatch_begin in one call.
+int linebatch_flush(line_batch_t *b, SDL_Renderer *ren);
+
+void linebatch_free(line_batch_t *b);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef ORIENT_H
+#define ORIENT_H
+
+// Wraps an angle into [0, 360)
+float orient_wrap_deg_360(float a);
+
+// Returns the signed smallest difference a-b in degrees, range (-180, +180)
+float orient_angle_diff_deg(float a, float b);
+
+/*
+ * Unit quaternion rotating device-body vectors into the local
+ * East-North-Up frame. Body axes follow the camera: +X right,
+ * +Y view direction, +Z up.
+ */
+typedef struct
+{
+    float w, x, y, z;
+} quat_t;
+
+quat_t orient_quat_identity(void);
+quat_t orient_quat_mul(quat_t a, quat_t b);
+quat_t orient_quat_normalize(quat_t q);
+
+// Rotation of angle_deg about the unit axis (ax, ay, az)
+quat_t orient_quat_axis_angle(float ax, float ay, float az, float angle_deg);
+
+// Yaw about Z, then pitch about X, then roll about Y (fixed local axes)
+quat_t orient_quat_from_euler(float yaw_deg, float pitch_deg, float roll_deg);
+
+// Inverse of orient_quat_from_euler (pitch in [-90, 90])
+void orient_quat_to_euler(quat_t q, float *yaw_deg, float *pitch_deg, float *roll_deg);
+
+void orient_quat_rotate(quat_t q, float x, float y, float z,
+                        float *ox, float *oy, float *oz);
+
+// Camera right / up / forward: the body axes rotated into the local frame
+void orient_quat_basis(quat_t q,
+                       float *rx, float *ry, float *rz,
+                       float *ux, float *uy, float *uz,
+                       float *fx, float *fy, float *fz);
+
+// Compass heading of the view direction, degrees from North toward West
+// (the sense of positive yaw)
+float orient_quat_heading(quat_t q);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <SDL.h>
+#include "orient.h"
+
+// Orientation change (degrees) that counts as motion
+#define PACER_IDLE_DEG 0.25f
+
+// Stillness needed before dropping to the idle rate
+#define PACER_IDLE_AFTER_MS 1000
+
+// How often an idle loop wakes to check the IMU and events
+#define PACER_IDLE_POLL_MS 10
+
+/*
+ * Frame scheduler for the render loop.
+ *
+ * Active: frames are paced to target_fps. When the renderer presents
+ * with vsync and the cap is at or above the display rate, the present
+ * itself does the waiting and the pacer never sleeps.
+ *
+ * Idle: once the view has stayed within PACER_IDLE_DEG for
+ * PACER_IDLE_AFTER_MS and nothing else is pending, frames drop to
+ * idle_fps. The loop keeps waking every PACER_IDLE_POLL_MS (or on
+ * any input event) to read the IMU, so motion brings the full rate
+ * back on the next poll.
+ */
+typedef struct
+{
+    int target_fps;         // active cap, 0 = uncapped
+    int idle_fps;
+    int vsync_hz;           // display rate when presenting with vsync, else 0
+
+    Uint64 freq;
+    Uint64 next;            // deadline of the next frame
+    Uint64 last_frame;      // when the last frame was rendered
+
+    quat_t ref_q;           // orientation motion is measured against
+    int have_ref;
+    Uint32 still_since;     // SDL_GetTicks() at the last motion
+    int idle;
+} frame_pacer_t;
+
+void pacer_init(frame_pacer_t *p, int target_fps, int idle_fps, int vsync_hz);
+
+// Feeds this iteration's orientation. busy forces the active rate
+// (input, cache rebuild, calibration). Returns 1 when idle.
+int pacer_update(frame_pacer_t *p, quat_t q, int busy, Uint32 now_ms);
+
+// 1 if a frame should be rendered this iteration
+int pacer_frame_due(frame_pacer_t *p);
+
+// Idle and not due: sleep one poll interval (wakes early on input)
+void pacer_idle_wait(frame_pacer_t *p);
+
+// After SDL_RenderPresent: sleeps to the next frame deadline if capped
+void pacer_frame_done(frame_pacer_t *p);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdio.h>
+#include <SDL.h>
+
+// Frames kept for the rolling min/avg/p99 statistics
+#define PROF_WINDOW 240
+
+// Render loop stages. PROF_FRAME covers the whole loop iteration.
+// PROF_LATENCY is not a stage but a measured value (prof_value):
+// motion-to-photon, from the IMU sample to SDL_RenderPresent returning.
+typedef enum
+{
+    PROF_IMU = 0,
+    PROF_ORIENT,
+    PROF_CAMERA,
+    PROF_COLLECT,
+    PROF_PROJECT,
+    PROF_DRAW,
+    PROF_PRESENT,
+    PROF_FRAME,
+    PROF_LATENCY,
+    PROF_STAGE_COUNT
+} prof_stage_t;
+
+typedef enum
+{
+    PROF_TRACE_NONE = 0,
+    PROF_TRACE_CSV,         // one row per frame, one column per stage
+    PROF_TRACE_CHROME       // chrome://tracing / Perfetto JSON
+} prof_trace_fmt_t;
+
+typedef struct
+{
+    float min_ms;
+    float avg_ms;
+    float p99_ms;
+    float max_ms;
+} prof_stats_t;
+
+/*
+ * Scoped stage timers for the render loop.
+ *
+ * Each stage's time per frame goes into a ring of the last
+ * PROF_WINDOW frames; statistics are computed from that ring on
+ * demand, so recording costs two counter reads per stage.
+ * Stages may be entered more than once per frame (times add up).
+ */
+typedef struct
+{
+    float ring[PROF_STAGE_COUNT][PROF_WINDOW];  // ms per frame
+    float cur[PROF_STAGE_COUNT];                // this frame so far
+    Uint64 start[PROF_STAGE_COUNT];
+    size_t head;        // next ring slot
+    size_t filled;      // valid ring slots
+
+    Uint64 origin;      // counter value at prof_init
+    double tick_ms;     // ms per performance counter tick
+    unsigned long frame;
+
+    FILE *trace;
+    prof_trace_fmt_t trace_fmt;
+    int trace_events;   // events written (Chrome trace comma handling)
+} profiler_t;
+
+void prof_init(profiler_t *p);
+
+// Opens a trace file. ".csv" selects CSV, anything else Chrome trace JSON.
+// returns 0 on success, -1 on failure.
+int prof_open_trace(profiler_t *p, const char *path);
+
+void prof_begin(profiler_t *p, prof_stage_t s);
+void prof_end(profiler_t *p, prof_stage_t s);
+
+// Records a stage timed by the caller (counter values t0 .. t1), for
+// work that is only known to belong to a frame after it ran
+void prof_add(profiler_t *p, prof_stage_t s, Uint64 t0, Uint64 t1);
+
+// Records a value measured elsewhere for this frame
+void prof_value(profiler_t *p, prof_stage_t s, float ms);
+
+// Starts the frame timer / commits this frame's stage times to the window
+void prof_frame_begin(profiler_t *p);
+void prof_frame_end(profiler_t *p);
+
+// Rolling statistics over the window (zeros before the first frame)
+void prof_stats(const profiler_t *p, prof_stage_t s, prof_stats_t *out);
+
+const char *prof_stage_name(prof_stage_t s);
+
+// Finishes and closes the trace file, if any
+void prof_close(profiler_t *p);
+
+#endif
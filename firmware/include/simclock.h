@@ -0,0 +1,45 @@
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+
+#include <stdint.h>
+
+// Rate steps each way: step s runs at sign(s) * 10^(|s| - 1), so 5 is x10000
+#define SIMCLOCK_MAX_STEP 5
+
+/*
+ * Simulated clock for the sky, decoupled from time().
+ *
+ * The simulated date is an anchor plus elapsed wall-clock time times
+ * the rate. Every rate change re-anchors at the current simulated
+ * date, so time never jumps when speeding up, stopping or reversing.
+ * Steps run x1, x10 .. x10000 forward, the same backward, and step 0
+ * stands still.
+ */
+typedef struct
+{
+    double anchor_jd;       // simulated JD (UTC) at anchor_ms
+    uint32_t anchor_ms;     // wall-clock ms, e.g. SDL_GetTicks()
+    int step;
+    int paused;
+} sim_clock_t;
+
+// Starts at jd_utc, running forward in real time.
+void simclock_init(sim_clock_t *c, double jd_utc, uint32_t now_ms);
+
+double simclock_jd(const sim_clock_t *c, uint32_t now_ms);
+
+// Simulated seconds per real second (negative runs backward, 0 when stopped)
+double simclock_rate(const sim_clock_t *c);
+
+// Moves the rate delta steps along the ladder, clamped at +-SIMCLOCK_MAX_STEP.
+void simclock_step(sim_clock_t *c, int delta, uint32_t now_ms);
+
+void simclock_toggle_pause(sim_clock_t *c, uint32_t now_ms);
+
+// Back to jd_utc (normally the wall-clock date) at x1.
+void simclock_reset(sim_clock_t *c, double jd_utc, uint32_t now_ms);
+
+// 1 while the sky turns faster than in real time (either direction)
+int simclock_fast(const sim_clock_t *c);
+
+#endif
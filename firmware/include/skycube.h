@@ -0,0 +1,90 @@
+#ifndef SKYCUBE_H
+#define SKYCUBE_H
+
+#include <stddef.h>
+#include <SDL.h>
+#include "astro.h"
+#include "skyview.h"
+#include "starcache.h"
+
+// Face texture edge in pixels (about one texel per screen pixel at 70 deg FOV)
+#define SKYCUBE_FACE_SIZE 1024
+
+// Pixels rendered past each face edge so sprites on a seam are whole on both sides
+#define SKYCUBE_GUARD_PX 4
+
+// Mesh cells per face edge (reprojection is exact at the vertices)
+#define SKYCUBE_GRID 32
+
+// Default full refresh interval even if nothing changed
+#define SKYCUBE_REFRESH_MS 10000
+
+#define SKYCUBE_VERTS ((SKYCUBE_GRID + 1) * (SKYCUBE_GRID + 1))
+
+/*
+ * Cached star field on the six faces of a cube of render targets.
+ *
+ * Faces are in the equatorial frame, where stars do not move, so
+ * sidereal time and the device orientation are both handled by the
+ * camera at draw time. Each frame draws a fixed grid mesh per face
+ * through the current camera (SDL_RenderGeometry, one call per face
+ * in view), so the per-frame cost does not depend on the catalog.
+ *
+ * Faces are redrawn through sky_view_t when the star cache or the
+ * magnitude cutoff changes, or every refresh_ms. Only one face is
+ * redrawn per skycube_update call, spreading a refresh over six
+ * frames instead of one long one.
+ *
+ * Stars are accumulated with additive blending, so the faces keep a
+ * transparent background and are added over whatever is below.
+ * The horizon is clipped in the mesh, not in the faces.
+ */
+typedef struct
+{
+    SDL_Texture *face[6];
+    camera_t face_cam[6];       // 90 deg plus guard band, equatorial
+    int size;
+
+    // Face grid: unit directions and texture coordinates
+    float dir[6][SKYCUBE_VERTS][3];
+    float tu[SKYCUBE_VERTS], tv[SKYCUBE_VERTS];
+
+    SDL_Vertex *verts;          // one face's clipped triangles
+    int vert_cap;
+
+    Uint32 refresh_ms;
+    Uint32 last_refresh;
+    unsigned dirty;             // bit per face still to redraw
+    unsigned generation;        // star cache buffer the faces show
+    size_t n_bright;
+    unsigned valid;             // bit per face drawn at least once
+
+    // Counters from the last skycube_draw
+    int n_faces;
+    int n_tris;
+} sky_cube_t;
+
+// size 0 uses SKYCUBE_FACE_SIZE. returns 0 on success, -1 if the
+// renderer has no render targets or a texture cannot be created.
+int skycube_init(sky_cube_t *c, SDL_Renderer *ren, int size, Uint32 refresh_ms);
+
+// Marks every face stale (e.g. after SDL_RENDER_TARGETS_RESET)
+void skycube_invalidate(sky_cube_t *c);
+
+// Redraws at most one stale face from sc using v as scratch.
+// Returns 1 if a face was drawn, 0 if none was due.
+int skycube_update(sky_cube_t *c, SDL_Renderer *ren, sky_view_t *v,
+                   const star_cache_buf_t *sc, size_t n_bright,
+                   SDL_Color color, Uint32 now_ms);
+
+// 1 once every face holds stars
+int skycube_ready(const sky_cube_t *c);
+
+// Draws the cube through cam (equatorial frame), clipped to the part
+// of the sky above local Up (zx, zy, zz). returns 0 on success, -1 on failure.
+int skycube_draw(sky_cube_t *c, SDL_Renderer *ren, const camera_t *cam,
+                 float zx, float zy, float zz);
+
+void skycube_free(sky_cube_t *c);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SKYINDEX_H
+#define SKYINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Cube-face tile grid over unit direction vectors.
+ *
+ * Each of the 6 cube faces is split into res x res tiles (equal-angle
+ * spacing, so tiles cover roughly the same solid angle). Stars are
+ * bucketed by tile once; a view cone query then returns only the
+ * tiles that can contain visible stars.
+ */
+typedef struct
+{
+    int res;                // tiles per cube-face edge
+    size_t tile_count;      // 6 * res * res
+
+    uint32_t *tile_start;   // tile_count + 1 offsets into order
+    uint32_t *order;        // star indices grouped by tile, ascending within a tile
+    size_t count;
+
+    // Tile centre direction and bounding cone (cos/sin of its angular radius)
+    float *tile_cx, *tile_cy, *tile_cz;
+    float *tile_cos_r, *tile_sin_r;
+} sky_index_t;
+
+// Buckets count unit vectors into tiles. returns 0 on success, -1 on failure.
+int skyindex_build(sky_index_t *idx, const float *x, const float *y, const float *z,
+                   size_t count, int res);
+
+// Tile id containing a unit direction.
+uint32_t skyindex_tile_of(const sky_index_t *idx, float x, float y, float z);
+
+// Collects non-empty tiles intersecting the cone around axis (unit vector)
+// with the given half angle. Returns the number of tiles written.
+size_t skyindex_query(const sky_index_t *idx, float ax, float ay, float az,
+                      float half_angle_deg, uint32_t *out_tiles, size_t max_tiles);
+
+void skyindex_free(sky_index_t *idx);
+
+#endif
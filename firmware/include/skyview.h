@@ -0,0 +1,61 @@
+#ifndef SKYVIEW_H
+#define SKYVIEW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "starcache.h"
+#include "starbatch.h"
+#include "astro.h"
+#include "atmos.h"
+
+/*
+ * Per-frame star layer, shared by the app and the benchmark.
+ *
+ * A frame runs three stages:
+ *   collect - walk tiles under the view frustum, keep stars inside
+ *             the magnitude prefix and above the horizon; with an
+ *             atmosphere, lift them by refraction and drop the ones
+ *             extinction dims past the cut
+ *   project - batch-project the packed candidates
+ *   draw    - queue sprites and submit them in one call
+ */
+typedef struct
+{
+    // Candidates packed for the batch projection kernel
+    float *cand_x, *cand_y, *cand_z;
+    unsigned char *cand_rad;
+    float *cand_xy;
+    unsigned char *cand_vis;
+    size_t cand_cap;
+
+    uint32_t *view_tiles;
+
+    star_batch_t batch;
+
+    // Counters from the last frame
+    size_t n_tiles;
+    size_t n_cand;
+    size_t n_visible;
+} sky_view_t;
+
+// ren may be NULL to skip drawing. returns 0 on success, -1 on failure.
+int skyview_init(sky_view_t *v, SDL_Renderer *ren, size_t max_stars);
+
+// Stage 1. cam and local Up (zx, zy, zz) are in the equatorial frame;
+// a zero Up keeps stars below the horizon too. atm may be NULL (no
+// atmosphere, and it must be NULL with a zero Up); mag_limit is the
+// cut n_bright was taken at. Returns the candidate count.
+size_t skyview_collect(sky_view_t *v, const star_cache_buf_t *sc, size_t n_bright,
+                       const camera_t *cam, float zx, float zy, float zz,
+                       const atmos_t *atm, float mag_limit);
+
+// Stage 2. cam in the equatorial frame. Returns the visible count.
+size_t skyview_project(sky_view_t *v, const camera_t *cam);
+
+// Stage 3.
+int skyview_draw(sky_view_t *v, SDL_Renderer *ren, SDL_Color color);
+
+void skyview_free(sky_view_t *v);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SOLSYS_H
+#define SOLSYS_H
+
+typedef enum
+{
+    SOLSYS_SUN = 0,
+    SOLSYS_MOON,
+    SOLSYS_MERCURY,
+    SOLSYS_VENUS,
+    SOLSYS_MARS,
+    SOLSYS_JUPITER,
+    SOLSYS_SATURN,
+    SOLSYS_URANUS,
+    SOLSYS_NEPTUNE,
+    SOLSYS_BODY_COUNT
+} solsys_body_t;
+
+// Chebyshev coefficients per coordinate, and the window they cover.
+// Twelve terms hold the Moon to well under an arcsecond over a day
+// (the benchmark's --ephem reports the worst error per body).
+#define SOLSYS_CHEB_N 12
+#define SOLSYS_SPAN_DAYS 1.0
+
+// TT - UTC (32.184 s + 37 leap seconds); the theories run on TT
+#define SOLSYS_TT_MINUS_UTC_S 69.184
+
+// Earth equatorial radius in AU, for the Moon's parallax
+#define SOLSYS_EARTH_RADIUS_AU 4.2635e-5
+
+/*
+ * Sun, Moon and planets from a cached Chebyshev ephemeris.
+ *
+ * The theories are truncated analytic ones: Keplerian elements with
+ * secular rates for the planets and the Earth (Standish, valid
+ * 1800-2050, arcminute level) and the ELP-2000 lunar series as
+ * abridged by Meeus (about 10" in longitude, 4" in latitude).
+ * Evaluating them every frame is wasteful, so each body's geocentric
+ * position is fit once per window; a frame then costs one Clenshaw
+ * sum per coordinate.
+ *
+ * Positions are in AU in the equatorial frame of date, the same
+ * frame as the star cache, so bodies project with the equatorial
+ * camera like stars do.
+ */
+typedef struct
+{
+    double t_mid;           // window center, JD (UTC)
+    double half_span;       // days
+    double coef[SOLSYS_BODY_COUNT][3][SOLSYS_CHEB_N];
+    int valid;
+
+    unsigned n_fits;        // windows fitted so far
+} solsys_t;
+
+void solsys_init(solsys_t *s);
+
+// Refits the window around jd_utc if jd_utc is outside the current one.
+// Returns 1 if it refit, 0 if not.
+int solsys_update(solsys_t *s, double jd_utc);
+
+// Geocentric position (AU, equatorial of date) from the cached window.
+// jd_utc should be inside it, i.e. after solsys_update for that date.
+void solsys_position(const solsys_t *s, solsys_body_t body, double jd_utc, double pos[3]);
+
+// Unit direction as seen from the observer, whose local Up (zx, zy, zz)
+// is in the equatorial frame; this corrects the Moon's parallax.
+void solsys_direction(const solsys_t *s, solsys_body_t body, double jd_utc,
+                      float zx, float zy, float zz, float *x, float *y, float *z);
+
+// Geocentric position straight from the theory (what the windows are fit
+// to), for checking the fit.
+void solsys_theory_position(solsys_body_t body, double jd_utc, double pos[3]);
+
+const char *solsys_name(solsys_body_t body);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef STARBATCH_H
+#define STARBATCH_H
+
+#include <stddef.h>
+#include <SDL.h>
+
+// One sprite per starcache_mag_to_radius value (0 = faint .. 3 = very bright)
+#define STARBATCH_SPRITES 4
+
+/*
+ * Collects star sprites into one vertex buffer and submits the whole
+ * star field with a single SDL_RenderGeometry call.
+ *
+ * Sprites are small pre-rendered discs packed in one atlas texture;
+ * radius 0 is a single pixel, larger radii get a soft 1 px edge.
+ */
+typedef struct
+{
+    SDL_Texture *atlas;
+    float u0[STARBATCH_SPRITES], v0[STARBATCH_SPRITES];
+    float u1[STARBATCH_SPRITES], v1[STARBATCH_SPRITES];
+    int size[STARBATCH_SPRITES];    // quad edge in pixels
+
+    SDL_Vertex *verts;              // 4 per star
+    int *indices;                   // 6 per star, fixed pattern
+    size_t count;
+    size_t cap;
+} star_batch_t;
+
+// returns 0 on success, -1 on failure.
+int starbatch_init(star_batch_t *b, SDL_Renderer *ren);
+
+void starbatch_begin(star_batch_t *b);
+
+// Queues a star centred on pixel (px, py). Returns -1 if out of memory.
+int starbatch_add(star_batch_t *b, int px, int py, int radius, SDL_Color color);
+
+// Draws everything queued since starbatch_begin in one call.
+int starbatch_flush(star_batch_t *b, SDL_Renderer *ren);
+
+void starbatch_free(star_batch_t *b);
+
+#endif
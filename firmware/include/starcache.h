@@ -0,0 +1,83 @@
+#ifndef STARCACHE_H
+#define STARCACHE_H
+
+#include <stddef.h>
+#include <SDL.h>
+#include "stars.h"
+#include "skyindex.h"
+
+// Tiles per cube-face edge for the cache's sky index
+#define STARCACHE_INDEX_RES 16
+
+// Date change that triggers re-propagating the catalog. Precession
+// moves stars about 0.14" per day, so this bounds the error at ~4".
+#define STARCACHE_EPOCH_DAYS 30.0
+
+/*
+ * Per-star data derived from the catalog, ready for the render loop.
+ * Indices match the catalog (brightest first).
+ *
+ * Positions are propagated from J2000 to the cache epoch (proper
+ * motion, precession, nutation) while the buffer is built, so the
+ * frame path reads them as-is.
+ */
+typedef struct
+{
+    float *ex, *ey, *ez;        // equatorial unit vectors of date
+    unsigned char *rad;         // draw radius from magnitude
+    float *mag;                 // catalog magnitude, for extinction
+    size_t count;
+    sky_index_t index;
+    unsigned generation;        // bumps on every completed rebuild
+    float build_ms;             // worker time spent building this buffer
+    double epoch_jd;            // date the positions were propagated to
+} star_cache_buf_t;
+
+/*
+ * Double-buffered star cache rebuilt on a worker thread.
+ *
+ * The worker fills the buffer the render thread is not using and
+ * publishes it under a short lock once it is complete. The render
+ * thread only ever takes that lock to read or release the front
+ * index, so it never waits on catalog math.
+ */
+typedef struct
+{
+    const star_catalog_t *catalog;
+    star_cache_buf_t bufs[2];
+
+    int front;      // latest complete buffer, -1 until the first build
+    int reading;    // buffer held by the render thread, -1 when none
+    int pending;    // rebuild requested
+    int building;   // worker is filling the back buffer
+    int quit;
+    unsigned generation;
+    double epoch_jd;    // epoch for the next build
+
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+} star_cache_t;
+
+// Starts the worker and queues the first build, propagated to epoch_jd
+// (ASTRO_JD_J2000 keeps catalog positions). returns 0 on success, -1 on failure.
+int starcache_start(star_cache_t *sc, const star_catalog_t *cat, double epoch_jd);
+
+// Moves the cache to a new date. Queues a rebuild (returns 1) only once
+// jd is more than STARCACHE_EPOCH_DAYS from the current epoch.
+int starcache_set_epoch(star_cache_t *sc, double jd);
+
+// 1 while a rebuild is queued or running
+int starcache_busy(star_cache_t *sc);
+
+// Latest complete buffer, or NULL before the first build finishes.
+// Every acquire must be paired with starcache_release.
+const star_cache_buf_t *starcache_acquire(star_cache_t *sc);
+void starcache_release(star_cache_t *sc);
+
+void starcache_stop(star_cache_t *sc);
+
+// Sprite radius (0 = faint .. 3 = very bright) for a magnitude
+int starcache_mag_to_radius(float mag);
+
+#endif
@@ -2,22 +2,113 @@
 #define STARS_H
 
 #include <stddef.h>
+#include <stdint.h>
 
+/*
+ * Star catalog stored as one array per field.
+ *
+ * Passes over the catalog (cache builds, magnitude cuts) only pull in
+ * the fields they read. Names are cold: they live in a single pool of
+ * NUL-terminated strings, referenced by offset. Every array starts on
+ * a STARS_BIN_ALIGN boundary, the same in memory as in the binary file.
+ */
 typedef struct
 {
-    char name[32];
-    float ra_hours;
-    float dec_deg;
-    float mag;
-} star_t;
+    float *ra_hours;        // J2000
+    float *dec_deg;
+    float *mag;
+    float *pm_ra_mas;       // proper motion, mas/yr (RA term includes cos dec)
+    float *pm_dec_mas;
+    uint32_t *name_off;     // each star's name, as an offset into names
+
+    char *names;            // name pool
+    size_t names_size;      // bytes, each name's NUL included
 
-typedef struct
-{
-    star_t *items;
     size_t count;
+
+    // Non-NULL when the arrays point into a mapped binary catalog.
+    void *map;
+    size_t map_size;
+
+    // Otherwise every array lives in this one heap block.
+    void *block;
+
+    // Stars are ordered brightest first (ascending magnitude).
+    int mag_sorted;
 } star_catalog_t;
 
+/*
+ * Binary catalog format (little or big endian, as written by the host).
+ *
+ *   [stars_bin_header_t][ra][dec][mag][pm_ra][pm_dec][name_off][names]
+ *
+ * Each section starts at the file offset given in the header, aligned
+ * to STARS_BIN_ALIGN, and is stored exactly as the catalog array, so
+ * a mapped file is used as catalog storage without parsing or copying.
+ *
+ * Any change to the layout or to the meaning of a header field bumps
+ * the version; the loader accepts only the current one.
+ *   1  star_t records, flags unused
+ *   2  flags: STARS_BIN_FLAG_MAG_SORTED
+ *   3  star_t gains proper motion
+ *   4  one section per field plus a name pool
+ */
+#define STARS_BIN_MAGIC     0x43535050u     // "PPSC"
+#define STARS_BIN_VERSION   4
+#define STARS_BIN_ENDIAN    0x01020304u     // reads back swapped on the wrong host
+#define STARS_BIN_ALIGN     64
+
+#define STARS_BIN_FLAG_MAG_SORTED   0x1u    // stars in ascending magnitude
+#define STARS_BIN_FLAGS_KNOWN       STARS_BIN_FLAG_MAG_SORTED
+
+typedef enum
+{
+    STARS_SEC_RA = 0,
+    STARS_SEC_DEC,
+    STARS_SEC_MAG,
+    STARS_SEC_PM_RA,
+    STARS_SEC_PM_DEC,
+    STARS_SEC_NAME_OFF,
+    STARS_SEC_NAMES,
+    STARS_SEC_COUNT
+} stars_section_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t endian;
+    uint32_t flags;
+    uint64_t count;
+    uint64_t names_size;
+    uint64_t offset[STARS_SEC_COUNT];   // file offset of each section
+} stars_bin_header_t;
+
+// CSV rows: name,ra_hours,dec_deg,mag[,pm_ra_mas,pm_dec_mas]
+// Loaded catalogs are always sorted by magnitude (see stars_mag_prefix).
 int stars_load_csv(star_catalog_t *cat, const char *path);
+
+// Maps a binary catalog written by stars_save_bin.
+// returns 0 on success, -1 on failure.
+int stars_load_bin(star_catalog_t *cat, const char *path);
+int stars_save_bin(const star_catalog_t *cat, const char *path);
+
+// Fills cat with count random stars, uniform over the sphere with a
+// roughly sky-like magnitude distribution (faint stars dominate).
+// Same seed -> same catalog on every platform. returns 0 on success.
+int stars_generate_synthetic(star_catalog_t *cat, size_t count, uint32_t seed);
+
+// Sorts the catalog brightest first. returns 0 on success, -1 on failure.
+int stars_sort_by_mag(star_catalog_t *cat);
+
+// Number of leading stars with mag <= mag_limit (binary search on a
+// magnitude-sorted catalog). Changing the limit only changes this length.
+size_t stars_mag_prefix(const star_catalog_t *cat, float mag_limit);
+
+// Name of star i ("" if it has none)
+const char *stars_name(const star_catalog_t *cat, size_t i);
+
 void stars_free(star_catalog_t *cat);
 
-#endif
\ No newline at end of file
+#endif
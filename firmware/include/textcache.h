@@ -0,0 +1,70 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#define TEXTCACHE_MAX_KEY   64      // longer strings go through the glyph path
+#define TEXTCACHE_GLYPH_FIRST 32    // printable ASCII
+#define TEXTCACHE_GLYPH_COUNT 95
+#define TEXTCACHE_MAX_FONTS 4
+
+// One rasterized string, keyed by (string, font, color)
+typedef struct
+{
+    char text[TEXTCACHE_MAX_KEY];
+    uint32_t hash;
+    TTF_Font *font;
+    SDL_Color color;
+    SDL_Texture *tex;
+    int w, h;
+    uint32_t last_used;     // frame stamp for LRU eviction
+} text_entry_t;
+
+// All printable ASCII glyphs of one font rasterized once (white)
+typedef struct
+{
+    TTF_Font *font;
+    SDL_Texture *tex;
+    int h;
+    int x[TEXTCACHE_GLYPH_COUNT];
+    int adv[TEXTCACHE_GLYPH_COUNT];
+} glyph_atlas_t;
+
+/*
+ * Text texture cache.
+ *
+ * Labels that repeat frame to frame are rasterized once and kept in
+ * a small LRU table. Strings that change every frame (numbers in the
+ * diagnostic overlay) are drawn from a per-font glyph atlas with one
+ * SDL_RenderGeometry call, so neither path rasterizes or creates
+ * textures in steady state.
+ */
+typedef struct
+{
+    SDL_Renderer *ren;
+    text_entry_t *entries;
+    size_t capacity;
+    uint32_t clock;
+
+    glyph_atlas_t atlases[TEXTCACHE_MAX_FONTS];
+    SDL_Vertex verts[4 * TEXTCACHE_MAX_KEY * 4];
+    int indices[6 * TEXTCACHE_MAX_KEY * 4];
+} text_cache_t;
+
+// returns 0 on success, -1 on failure.
+int textcache_init(text_cache_t *tc, SDL_Renderer *ren, size_t capacity);
+
+// Draws a (mostly static) string through the LRU texture cache.
+void textcache_draw(text_cache_t *tc, TTF_Font *font, const char *msg,
+                    SDL_Color color, int x, int y);
+
+// Draws a fast-changing string glyph by glyph from the font's atlas.
+void textcache_draw_glyphs(text_cache_t *tc, TTF_Font *font, const char *msg,
+                           SDL_Color color, int x, int y);
+
+void textcache_free(text_cache_t *tc);
+
+#endif
@@ -22,14 +22,6 @@ static void normalize(float *x, float *y, float *z)
     }
 }
 
-static void cross(float ax, float ay, float az, float bx, float by, float bz,
-                    float *ox, float *oy, float *oz)
-{
-    *ox = ay*bz - az*by;
-    *oy = az*bx - ax*bz;
-    *oz = ax*by - ay*bx;
-}
-
 static float dot(float ax, float ay, float az, float bx, float by, float bz)
 {
     return ax*bx + ay*by + az*bz;
@@ -50,84 +42,96 @@ void astro_radec_to_unit(float ra_hours, float dec_deg, float *x, float *y, floa
     normalize(x, y, z);
 }
 
-void astro_camera_basis(float yaw_deg, float pitch_deg, float roll_deg,
-                        float *rx, float *ry, float *rz,
-                        float *ux, float *uy, float *uz,
-                        float *fx, float *fy, float *fz)
+// Inward unit normal a*s + b*t, for the frustum side planes
+static void plane_normal(float *n, float ax, float ay, float az, float s,
+                         float bx, float by, float bz, float t)
 {
-    float yaw   = DEG2RAD_F(yaw_deg);
-    float pitch = DEG2RAD_F(pitch_deg);
-    float roll  = DEG2RAD_F(roll_deg);
+    n[0] = ax*s + bx*t;
+    n[1] = ay*s + by*t;
+    n[2] = az*s + bz*t;
+    normalize(&n[0], &n[1], &n[2]);
+}
 
-    // Start with a forward vector looking down +Y
-    float f0x = 0.f, f0y = 1.f, f0z = 0.f;
-    float u0x = 0.f, u0y = 0.f, u0z = 1.f;
+// Frustum planes from the current basis
+static void camera_update_planes(camera_t *c)
+{
+    // Left/right: cx/cz >= -tan_half_w and <= tan_half_w
+    plane_normal(c->planes[0], c->rx, c->ry, c->rz,  1.0f, c->fx, c->fy, c->fz, c->tan_half_w);
+    plane_normal(c->planes[1], c->rx, c->ry, c->rz, -1.0f, c->fx, c->fy, c->fz, c->tan_half_w);
 
-    // Apply yaw about z
-    float cy = cosf(yaw), sy = sinf(yaw);
-    float fx1 = cy*f0x - sy*f0y;
-    float fy1 = sy*f0x + cy*f0y;
-    float fz1 = f0z;
+    // Top/bottom: screen y grows downward, so top is +up
+    plane_normal(c->planes[2], c->ux, c->uy, c->uz, -1.0f, c->fx, c->fy, c->fz, c->tan_half_h);
+    plane_normal(c->planes[3], c->ux, c->uy, c->uz,  1.0f, c->fx, c->fy, c->fz, c->tan_half_h);
+}
 
-    float ux1 = cy*u0x - sy*u0y;
-    float uy1 = sy*u0x + cy*u0y;
-    float uz1 = u0z;
+void astro_camera_init(camera_t *cam, int w, int h, float fov_deg)
+{
+    cam->w = w;
+    cam->h = h;
+    cam->fov_deg = fov_deg;
+
+    cam->tan_half_w = tanf(DEG2RAD_F(fov_deg) * 0.5f);
+    cam->tan_half_h = cam->tan_half_w * (float)h / (float)w;
+    cam->focal = (float)w / (2.0f * cam->tan_half_w);
+    cam->cx = (float)w * 0.5f;
+    cam->cy = (float)h * 0.5f;
+    cam->half_angle_deg = astro_view_cone_half_angle(w, h, fov_deg);
+
+    astro_camera_set_basis(cam, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 1.f, 0.f);
+}
 
-    // Apply pitch about x
-    float cp = cosf(pitch), sp = sinf(pitch);
-    float fx2 = fx1;
-    float fy2 = cp*fy1 - sp*fz1;
-    float fz2 = sp*fy1 + cp*fz1;
+void astro_camera_set_basis(camera_t *cam,
+                            float rx, float ry, float rz,
+                            float ux, float uy, float uz,
+                            float fx, float fy, float fz)
+{
+    cam->rx = rx; cam->ry = ry; cam->rz = rz;
+    cam->ux = ux; cam->uy = uy; cam->uz = uz;
+    cam->fx = fx; cam->fy = fy; cam->fz = fz;
 
-    float ux2 = ux1;
-    float uy2 = cp*uy1 - sp*uz1;
-    float uz2 = sp*uy1 + cp*uz1;
+    camera_update_planes(cam);
+}
 
-    // Apply roll about Y
-    float cr = cosf(roll), sr = sinf(roll);
-    *fx = cr*fx2 + sr*fz2;
-    *fy = fy2;
-    *fz = -sr*fx2 + cr*fz2;
+void astro_camera_set_quat(camera_t *cam, quat_t q)
+{
+    float rx, ry, rz, ux, uy, uz, fx, fy, fz;
+    orient_quat_basis(q, &rx, &ry, &rz, &ux, &uy, &uz, &fx, &fy, &fz);
 
-    *ux = cr*ux2 + sr*uz2;
-    *uy = uy2;
-    *uz = -sr*ux2 + cr*uz2;
+    astro_camera_set_basis(cam, rx, ry, rz, ux, uy, uz, fx, fy, fz);
+}
 
-    normalize(fx, fy, fz);
-    normalize(ux, uy, uz);
+void astro_camera_rotated(const camera_t *src, const float m[9], camera_t *dst)
+{
+    float rx, ry, rz, ux, uy, uz, fx, fy, fz;
+    astro_mat3_tmul(m, src->rx, src->ry, src->rz, &rx, &ry, &rz);
+    astro_mat3_tmul(m, src->ux, src->uy, src->uz, &ux, &uy, &uz);
+    astro_mat3_tmul(m, src->fx, src->fy, src->fz, &fx, &fy, &fz);
 
-    // Right = forward x up
-    cross(*fx, *fy, *fz, *ux, *uy, *uz, rx, ry, rz);
-    normalize(rx, ry, rz);
+    if (dst != src)
+    {
+        *dst = *src;
+    }
 
-    // Re-orthoganalize up = right x forward
-    cross(*rx, *ry, *rz, *fx, *fy, *fz, ux, uy ,uz);
-    normalize(ux, uy, uz);
+    astro_camera_set_basis(dst, rx, ry, rz, ux, uy, uz, fx, fy, fz);
 }
 
-int astro_project_dir(float dirx, float diry, float dirz,
-                      float rx, float ry, float rz,
-                      float ux, float uy, float uz,
-                      float fx, float fy, float fz,
-                      int w, int h, float fov_deg,
-                      int *outx, int *outy, float *out_depth)
+int astro_camera_project(const camera_t *cam, float dirx, float diry, float dirz,
+                         int *outx, int *outy, float *out_depth)
 {
     // dir in camera coords using dot with basis vectors
-    float cx = dot(dirx, diry, dirz, rx, ry, rz);
-    float cy = dot(dirx, diry, dirz, ux, uy, uz);
-    float cz = dot(dirx, diry, dirz, fx, fy, fz);
+    float cx = dot(dirx, diry, dirz, cam->rx, cam->ry, cam->rz);
+    float cy = dot(dirx, diry, dirz, cam->ux, cam->uy, cam->uz);
+    float cz = dot(dirx, diry, dirz, cam->fx, cam->fy, cam->fz);
 
     // behind camera
     if (cz <= 1e-4f) return 0;
 
     // perspective projection
-    float fov = DEG2RAD_F(fov_deg);
-    float focal = (float)w / (2.0f * tanf(fov * 0.5f));
-
-    float sx = (cx / cz) * focal + (float)w * 0.5f;
-    float sy = (-cy / cz) * focal +(float)h * 0.5f;
+    float inv = cam->focal / cz;
+    float sx = cx * inv + cam->cx;
+    float sy = -cy * inv + cam->cy;
 
-    if (sx < 0 || sx >= w || sy < 0 || sy >= h)
+    if (sx < 0 || sx >= cam->w || sy < 0 || sy >= cam->h)
     {
         return 0;
     }
@@ -159,6 +163,32 @@ double astro_julian_date_utc(int year, int month, int day, int hour, int min, do
     return (double)jdn + day_fraction;
 }
 
+void astro_jd_to_calendar(double jd_utc, int *year, int *month, int *day,
+                          int *hour, int *min, double *sec)
+{
+    // Inverse of the above (Gregorian, Richards' algorithm)
+    double jd = jd_utc + 0.5;
+    long j = (long)floor(jd);
+    double f = jd - (double)j;
+
+    long a = j + 32044;
+    long b = (4*a + 3) / 146097;
+    long c = a - 146097*b / 4;
+    long d = (4*c + 3) / 1461;
+    long e = c - 1461*d / 4;
+    long m = (5*e + 2) / 153;
+
+    *day = (int)(e - (153*m + 2) / 5 + 1);
+    *month = (int)(m + 3 - 12*(m / 10));
+    *year = (int)(100*b + d - 4800 + m / 10);
+
+    double s = f * 86400.0;
+    *hour = (int)(s / 3600.0);
+    s -= *hour * 3600.0;
+    *min = (int)(s / 60.0);
+    *sec = s - *min * 60.0;
+}
+
 // Greenwich Mean Sidereal Time (hours) from JD(UTC) (approx, good enough for now)
 double astro_gmst_hours(double jd_utc)
 {
@@ -227,4 +257,145 @@ void astro_altaz_to_unit(float alt_deg, float az_deg, float *x, float *y, float
     if (x) *x = (float)(ca * saz);
     if (y) *y = (float)(ca * caz);
     if (z) *z = (float)(sa);
-}
\ No newline at end of file
+}
+
+/*
+ * Equatorial -> ENU rotation.
+ *
+ * Rotating by -LST about the pole gives hour-angle coordinates
+ * p = (cos(dec)cos(H), -cos(dec)sin(H), sin(dec)). From the same
+ * spherical relations used in astro_radec_to_altaz:
+ *   East  =  p.y
+ *   North = -sin(lat)*p.x + cos(lat)*p.z
+ *   Up    =  cos(lat)*p.x + sin(lat)*p.z
+ */
+void astro_equatorial_to_local_matrix(double jd_utc, double lat_deg, double lon_deg, float m[9])
+{
+    double lst = DEG2RAD_D(astro_lst_hours(jd_utc, lon_deg) * 15.0);
+    double lat = DEG2RAD_D(lat_deg);
+
+    double ct = cos(lst), st = sin(lst);
+    double cl = cos(lat), sl = sin(lat);
+
+    m[0] = (float)(-st);     m[1] = (float)( ct);     m[2] = 0.0f;
+    m[3] = (float)(-sl*ct);  m[4] = (float)(-sl*st);  m[5] = (float)cl;
+    m[6] = (float)( cl*ct);  m[7] = (float)( cl*st);  m[8] = (float)sl;
+}
+
+// c = a * b for row-major 3x3
+static void mat3_mul_d(const double a[9], const double b[9], double c[9])
+{
+    for (int r = 0; r < 3; r++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            c[3*r + k] = a[3*r]*b[k] + a[3*r + 1]*b[3 + k] + a[3*r + 2]*b[6 + k];
+        }
+    }
+}
+
+void astro_epoch_matrix(double jd_utc, float m[9])
+{
+    const double AS2RAD = M_PI / (180.0 * 3600.0);
+    double t = (jd_utc - ASTRO_JD_J2000) / 36525.0;
+
+    // Precession angles (Lieske 1977), arcseconds
+    double zeta  = (2306.2181 + (0.30188 + 0.017998*t)*t)*t * AS2RAD;
+    double z     = (2306.2181 + (1.09468 + 0.018203*t)*t)*t * AS2RAD;
+    double theta = (2004.3109 - (0.42665 + 0.041833*t)*t)*t * AS2RAD;
+
+    double cze = cos(zeta), sze = sin(zeta);
+    double cz = cos(z), sz = sin(z);
+    double cth = cos(theta), sth = sin(theta);
+
+    double p[9] = {
+        cze*cth*cz - sze*sz,   -sze*cth*cz - cze*sz,   -sth*cz,
+        cze*cth*sz + sze*cz,   -sze*cth*sz + cze*cz,   -sth*sz,
+        cze*sth,               -sze*sth,                cth
+    };
+
+    // Nutation, leading terms: Moon's node, Sun and Moon mean longitudes
+    double om = DEG2RAD_D(125.04452 - 1934.136261*t);
+    double ls = DEG2RAD_D(280.4665 + 36000.7698*t);
+    double lm = DEG2RAD_D(218.3165 + 481267.8813*t);
+
+    double dpsi = (-17.20*sin(om) - 1.32*sin(2.0*ls) - 0.23*sin(2.0*lm) + 0.21*sin(2.0*om)) * AS2RAD;
+    double deps = (  9.20*cos(om) + 0.57*cos(2.0*ls) + 0.10*cos(2.0*lm) - 0.09*cos(2.0*om)) * AS2RAD;
+
+    double eps0 = (84381.448 - (46.8150 + (0.00059 - 0.001813*t)*t)*t) * AS2RAD;
+    double eps = eps0 + deps;
+
+    double ce0 = cos(eps0), se0 = sin(eps0);
+    double ce = cos(eps), se = sin(eps);
+    double cp = cos(dpsi), sp = sin(dpsi);
+
+    double n[9] = {
+        cp,        -sp*ce0,                -sp*se0,
+        sp*ce,      cp*ce*ce0 + se*se0,     cp*ce*se0 - se*ce0,
+        sp*se,      cp*se*ce0 - ce*se0,     cp*se*se0 + ce*ce0
+    };
+
+    // Equation of the equinoxes: true RA measured from the mean equinox
+    double ee = dpsi * ce;
+    double cq = cos(ee), sq = sin(ee);
+    double q[9] = {
+         cq,  sq,  0.0,
+        -sq,  cq,  0.0,
+         0.0, 0.0, 1.0
+    };
+
+    double np[9], r[9];
+    mat3_mul_d(n, p, np);
+    mat3_mul_d(q, np, r);
+
+    for (int i = 0; i < 9; i++)
+    {
+        m[i] = (float)r[i];
+    }
+}
+
+void astro_radec_pm_to_unit(float ra_hours, float dec_deg,
+                            float pm_ra_mas, float pm_dec_mas, double years,
+                            float *x, float *y, float *z)
+{
+    if (pm_ra_mas == 0.0f && pm_dec_mas == 0.0f)
+    {
+        astro_radec_to_unit(ra_hours, dec_deg, x, y, z);
+        return;
+    }
+
+    double ra = DEG2RAD_D((double)ra_hours * 15.0);
+    double dec = DEG2RAD_D((double)dec_deg);
+    double ca = cos(ra), sa = sin(ra);
+    double cd = cos(dec), sd = sin(dec);
+
+    // Move along the local east/north directions (no pole singularity)
+    const double MAS2RAD = M_PI / (180.0 * 3600.0 * 1000.0);
+    double da = (double)pm_ra_mas * MAS2RAD * years;
+    double dd = (double)pm_dec_mas * MAS2RAD * years;
+
+    double vx = cd*ca + da*(-sa) + dd*(-sd*ca);
+    double vy = cd*sa + da*( ca) + dd*(-sd*sa);
+    double vz = sd               + dd*( cd);
+
+    double inv = 1.0 / sqrt(vx*vx + vy*vy + vz*vz);
+    *x = (float)(vx * inv);
+    *y = (float)(vy * inv);
+    *z = (float)(vz * inv);
+}
+
+void astro_mat3_tmul(const float m[9], float x, float y, float z,
+                     float *ox, float *oy, float *oz)
+{
+    *ox = m[0]*x + m[3]*y + m[6]*z;
+    *oy = m[1]*x + m[4]*y + m[7]*z;
+    *oz = m[2]*x + m[5]*y + m[8]*z;
+}
+
+float astro_view_cone_half_angle(int w, int h, float fov_deg)
+{
+    // tan(half diagonal) = tan(half horizontal) * diagonal / width
+    float t = tanf(DEG2RAD_F(fov_deg) * 0.5f);
+    float aspect = (float)h / (float)w;
+    return RAD2DEG_F(atanf(t * sqrtf(1.0f + aspect*aspect)));
+}
@@ -0,0 +1,289 @@
+#include "astro.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Batch projection kernels.
+ *
+ * The implementation is picked at build time from the target's
+ * vector extensions: NEON on the Pi (AArch64, or ARMv7 built with
+ * -mfpu=neon), AVX or SSE2 on x86, and a scalar loop everywhere else.
+ * Define ASTRO_NO_SIMD to force the scalar path.
+ */
+#if !defined(ASTRO_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+    #include <arm_neon.h>
+    #define ASTRO_BATCH_NEON 1
+#elif !defined(ASTRO_NO_SIMD) && defined(__AVX__)
+    #include <immintrin.h>
+    #define ASTRO_BATCH_AVX 1
+#elif !defined(ASTRO_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+    #include <emmintrin.h>
+    #define ASTRO_BATCH_SSE 1
+#endif
+
+// Same near-plane as astro_camera_project
+#define NEAR_Z 1e-4f
+
+// Per-call constants, computed once instead of once per star
+typedef struct
+{
+    float rx, ry, rz;
+    float ux, uy, uz;
+    float fx, fy, fz;
+    float focal;
+    float half_w, half_h;
+    float w, h;
+} proj_consts_t;
+
+// Scalar kernel, also used for the tail of the SIMD loops
+static size_t project_scalar(const float *dx, const float *dy, const float *dz,
+                             size_t begin, size_t n, const proj_consts_t *k,
+                             float *out_xy, unsigned char *out_vis)
+{
+    size_t visible = 0;
+
+    for (size_t i = begin; i < n; i++)
+    {
+        float x = dx[i], y = dy[i], z = dz[i];
+        float cx = x*k->rx + y*k->ry + z*k->rz;
+        float cy = x*k->ux + y*k->uy + z*k->uz;
+        float cz = x*k->fx + y*k->fy + z*k->fz;
+
+        float inv = (cz > NEAR_Z) ? 1.0f / cz : 0.0f;
+        float sx = k->half_w + cx * inv * k->focal;
+        float sy = k->half_h - cy * inv * k->focal;
+
+        int vis = (cz > NEAR_Z) & (sx >= 0.f) & (sx < k->w) & (sy >= 0.f) & (sy < k->h);
+
+        out_xy[2*i]     = sx;
+        out_xy[2*i + 1] = sy;
+        out_vis[i] = (unsigned char)vis;
+        visible += (size_t)vis;
+    }
+
+    return visible;
+}
+
+#if defined(ASTRO_BATCH_NEON)
+
+static inline float32x4_t recip_f32x4(float32x4_t x)
+{
+#if defined(__aarch64__)
+    return vdivq_f32(vdupq_n_f32(1.0f), x);
+#else
+    // ARMv7 has no vector divide: estimate + two Newton-Raphson steps
+    float32x4_t r = vrecpeq_f32(x);
+    r = vmulq_f32(vrecpsq_f32(x, r), r);
+    r = vmulq_f32(vrecpsq_f32(x, r), r);
+    return r;
+#endif
+}
+
+static size_t project_simd(const float *dx, const float *dy, const float *dz,
+                           size_t n, const proj_consts_t *k,
+                           float *out_xy, unsigned char *out_vis)
+{
+    const float32x4_t rx = vdupq_n_f32(k->rx), ry = vdupq_n_f32(k->ry), rz = vdupq_n_f32(k->rz);
+    const float32x4_t ux = vdupq_n_f32(k->ux), uy = vdupq_n_f32(k->uy), uz = vdupq_n_f32(k->uz);
+    const float32x4_t fx = vdupq_n_f32(k->fx), fy = vdupq_n_f32(k->fy), fz = vdupq_n_f32(k->fz);
+    const float32x4_t focal = vdupq_n_f32(k->focal);
+    const float32x4_t hw = vdupq_n_f32(k->half_w), hh = vdupq_n_f32(k->half_h);
+    const float32x4_t w = vdupq_n_f32(k->w), h = vdupq_n_f32(k->h);
+    const float32x4_t zero = vdupq_n_f32(0.0f), near_z = vdupq_n_f32(NEAR_Z);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    uint32x4_t count = vdupq_n_u32(0);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t x = vld1q_f32(dx + i);
+        float32x4_t y = vld1q_f32(dy + i);
+        float32x4_t z = vld1q_f32(dz + i);
+
+        float32x4_t cx = vmlaq_f32(vmlaq_f32(vmulq_f32(x, rx), y, ry), z, rz);
+        float32x4_t cy = vmlaq_f32(vmlaq_f32(vmulq_f32(x, ux), y, uy), z, uz);
+        float32x4_t cz = vmlaq_f32(vmlaq_f32(vmulq_f32(x, fx), y, fy), z, fz);
+
+        uint32x4_t front = vcgtq_f32(cz, near_z);
+        // Keep the reciprocal finite for lanes behind the camera
+        float32x4_t inv = vmulq_f32(recip_f32x4(vbslq_f32(front, cz, one)), focal);
+
+        float32x4_t sx = vmlaq_f32(hw, cx, inv);
+        float32x4_t sy = vmlsq_f32(hh, cy, inv);
+
+        uint32x4_t m = vandq_u32(front, vcgeq_f32(sx, zero));
+        m = vandq_u32(m, vcltq_f32(sx, w));
+        m = vandq_u32(m, vcgeq_f32(sy, zero));
+        m = vandq_u32(m, vcltq_f32(sy, h));
+
+        float32x4x2_t xy = { { sx, sy } };
+        vst2q_f32(out_xy + 2*i, xy);
+
+        // 0xFFFFFFFF lanes -> 1 byte per lane
+        uint16x4_t m16 = vmovn_u32(m);
+        uint8x8_t m8 = vand_u8(vmovn_u16(vcombine_u16(m16, m16)), vdup_n_u8(1));
+        uint32_t bytes = vget_lane_u32(vreinterpret_u32_u8(m8), 0);
+        memcpy(out_vis + i, &bytes, 4);
+
+        count = vsubq_u32(count, m);    // all-ones lanes count as +1
+    }
+
+    size_t visible = (size_t)vgetq_lane_u32(count, 0) + vgetq_lane_u32(count, 1) +
+                     vgetq_lane_u32(count, 2) + vgetq_lane_u32(count, 3);
+
+    return visible + project_scalar(dx, dy, dz, i, n, k, out_xy, out_vis);
+}
+
+#elif defined(ASTRO_BATCH_AVX)
+
+static size_t project_simd(const float *dx, const float *dy, const float *dz,
+                           size_t n, const proj_consts_t *k,
+                           float *out_xy, unsigned char *out_vis)
+{
+    const __m256 rx = _mm256_set1_ps(k->rx), ry = _mm256_set1_ps(k->ry), rz = _mm256_set1_ps(k->rz);
+    const __m256 ux = _mm256_set1_ps(k->ux), uy = _mm256_set1_ps(k->uy), uz = _mm256_set1_ps(k->uz);
+    const __m256 fx = _mm256_set1_ps(k->fx), fy = _mm256_set1_ps(k->fy), fz = _mm256_set1_ps(k->fz);
+    const __m256 focal = _mm256_set1_ps(k->focal);
+    const __m256 hw = _mm256_set1_ps(k->half_w), hh = _mm256_set1_ps(k->half_h);
+    const __m256 w = _mm256_set1_ps(k->w), h = _mm256_set1_ps(k->h);
+    const __m256 zero = _mm256_setzero_ps(), near_z = _mm256_set1_ps(NEAR_Z);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    size_t visible = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(dx + i);
+        __m256 y = _mm256_loadu_ps(dy + i);
+        __m256 z = _mm256_loadu_ps(dz + i);
+
+        __m256 cx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, rx), _mm256_mul_ps(y, ry)), _mm256_mul_ps(z, rz));
+        __m256 cy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, ux), _mm256_mul_ps(y, uy)), _mm256_mul_ps(z, uz));
+        __m256 cz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, fx), _mm256_mul_ps(y, fy)), _mm256_mul_ps(z, fz));
+
+        __m256 front = _mm256_cmp_ps(cz, near_z, _CMP_GT_OQ);
+        __m256 inv = _mm256_mul_ps(_mm256_div_ps(one, _mm256_blendv_ps(one, cz, front)), focal);
+
+        __m256 sx = _mm256_add_ps(hw, _mm256_mul_ps(cx, inv));
+        __m256 sy = _mm256_sub_ps(hh, _mm256_mul_ps(cy, inv));
+
+        __m256 m = _mm256_and_ps(front, _mm256_cmp_ps(sx, zero, _CMP_GE_OQ));
+        m = _mm256_and_ps(m, _mm256_cmp_ps(sx, w, _CMP_LT_OQ));
+        m = _mm256_and_ps(m, _mm256_cmp_ps(sy, zero, _CMP_GE_OQ));
+        m = _mm256_and_ps(m, _mm256_cmp_ps(sy, h, _CMP_LT_OQ));
+
+        // unpack works per 128-bit half, so fix up the halves afterwards
+        __m256 lo = _mm256_unpacklo_ps(sx, sy);     // x0 y0 x1 y1 | x4 y4 x5 y5
+        __m256 hi = _mm256_unpackhi_ps(sx, sy);     // x2 y2 x3 y3 | x6 y6 x7 y7
+        _mm256_storeu_ps(out_xy + 2*i,     _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out_xy + 2*i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+
+        int bits = _mm256_movemask_ps(m);
+        for (int b = 0; b < 8; b++)
+        {
+            out_vis[i + b] = (unsigned char)((bits >> b) & 1);
+            visible += (size_t)((bits >> b) & 1);
+        }
+    }
+
+    return visible + project_scalar(dx, dy, dz, i, n, k, out_xy, out_vis);
+}
+
+#elif defined(ASTRO_BATCH_SSE)
+
+static size_t project_simd(const float *dx, const float *dy, const float *dz,
+                           size_t n, const proj_consts_t *k,
+                           float *out_xy, unsigned char *out_vis)
+{
+    const __m128 rx = _mm_set1_ps(k->rx), ry = _mm_set1_ps(k->ry), rz = _mm_set1_ps(k->rz);
+    const __m128 ux = _mm_set1_ps(k->ux), uy = _mm_set1_ps(k->uy), uz = _mm_set1_ps(k->uz);
+    const __m128 fx = _mm_set1_ps(k->fx), fy = _mm_set1_ps(k->fy), fz = _mm_set1_ps(k->fz);
+    const __m128 focal = _mm_set1_ps(k->focal);
+    const __m128 hw = _mm_set1_ps(k->half_w), hh = _mm_set1_ps(k->half_h);
+    const __m128 w = _mm_set1_ps(k->w), h = _mm_set1_ps(k->h);
+    const __m128 zero = _mm_setzero_ps(), near_z = _mm_set1_ps(NEAR_Z);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    size_t visible = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(dx + i);
+        __m128 y = _mm_loadu_ps(dy + i);
+        __m128 z = _mm_loadu_ps(dz + i);
+
+        __m128 cx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, rx), _mm_mul_ps(y, ry)), _mm_mul_ps(z, rz));
+        __m128 cy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, ux), _mm_mul_ps(y, uy)), _mm_mul_ps(z, uz));
+        __m128 cz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, fx), _mm_mul_ps(y, fy)), _mm_mul_ps(z, fz));
+
+        // SSE2 has no blend: select cz or 1 with and/andnot
+        __m128 front = _mm_cmpgt_ps(cz, near_z);
+        __m128 safe_z = _mm_or_ps(_mm_and_ps(front, cz), _mm_andnot_ps(front, one));
+        __m128 inv = _mm_mul_ps(_mm_div_ps(one, safe_z), focal);
+
+        __m128 sx = _mm_add_ps(hw, _mm_mul_ps(cx, inv));
+        __m128 sy = _mm_sub_ps(hh, _mm_mul_ps(cy, inv));
+
+        __m128 m = _mm_and_ps(front, _mm_cmpge_ps(sx, zero));
+        m = _mm_and_ps(m, _mm_cmplt_ps(sx, w));
+        m = _mm_and_ps(m, _mm_cmpge_ps(sy, zero));
+        m = _mm_and_ps(m, _mm_cmplt_ps(sy, h));
+
+        _mm_storeu_ps(out_xy + 2*i,     _mm_unpacklo_ps(sx, sy));
+        _mm_storeu_ps(out_xy + 2*i + 4, _mm_unpackhi_ps(sx, sy));
+
+        int bits = _mm_movemask_ps(m);
+        for (int b = 0; b < 4; b++)
+        {
+            out_vis[i + b] = (unsigned char)((bits >> b) & 1);
+            visible += (size_t)((bits >> b) & 1);
+        }
+    }
+
+    return visible + project_scalar(dx, dy, dz, i, n, k, out_xy, out_vis);
+}
+
+#endif
+
+const char *astro_batch_impl(void)
+{
+#if defined(ASTRO_BATCH_NEON)
+    return "neon";
+#elif defined(ASTRO_BATCH_AVX)
+    return "avx";
+#elif defined(ASTRO_BATCH_SSE)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+size_t astro_camera_project_batch(const camera_t *cam,
+                                  const float *dx, const float *dy, const float *dz, size_t n,
+                                  float *out_xy, unsigned char *out_vis)
+{
+    if (!cam || !dx || !dy || !dz || !out_xy || !out_vis || n == 0)
+    {
+        return 0;
+    }
+
+    proj_consts_t k;
+    k.rx = cam->rx; k.ry = cam->ry; k.rz = cam->rz;
+    k.ux = cam->ux; k.uy = cam->uy; k.uz = cam->uz;
+    k.fx = cam->fx; k.fy = cam->fy; k.fz = cam->fz;
+    k.focal = cam->focal;
+    k.half_w = cam->cx;
+    k.half_h = cam->cy;
+    k.w = (float)cam->w;
+    k.h = (float)cam->h;
+
+#if defined(ASTRO_BATCH_NEON) || defined(ASTRO_BATCH_AVX) || defined(ASTRO_BATCH_SSE)
+    return project_simd(dx, dy, dz, n, &k, out_xy, out_vis);
+#else
+    return project_scalar(dx, dy, dz, 0, n, &k, out_xy, out_vis);
+#endif
+}
@@ -0,0 +1,112 @@
+#include "atmos.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEG2RAD_D(x) ((double)(x) * (M_PI / 180.0))
+#define RAD2DEG_D(x) ((double)(x) * (180.0 / M_PI))
+
+/*
+ * Refraction for a true altitude, in degrees (Saemundsson 1986, the
+ * inverse of Bennett's formula), scaled from 10 C / 1010 hPa.
+ */
+static double refraction_deg(double alt_deg, double temp_c, double pressure_hpa)
+{
+    double r_arcmin = 1.02 / tan(DEG2RAD_D(alt_deg + 10.3 / (alt_deg + 5.11)));
+    r_arcmin *= (pressure_hpa / 1010.0) * (283.0 / (273.0 + temp_c));
+
+    // The fit goes slightly negative at the zenith
+    return (r_arcmin > 0.0) ? r_arcmin / 60.0 : 0.0;
+}
+
+// Relative airmass at an apparent altitude (Kasten & Young 1989)
+static double airmass(double alt_deg)
+{
+    if (alt_deg < 0.0)
+    {
+        alt_deg = 0.0;
+    }
+    return 1.0 / (sin(DEG2RAD_D(alt_deg)) + 0.50572 * pow(alt_deg + 6.07995, -1.6364));
+}
+
+int atmos_init(atmos_t *a, float temp_c, float pressure_hpa)
+{
+    if (!a)
+    {
+        return -1;
+    }
+
+    if (temp_c < -60.0f || temp_c > 60.0f || pressure_hpa < 300.0f || pressure_hpa > 1100.0f)
+    {
+        fprintf(stderr, "atmos: conditions out of range (%.1f C, %.0f hPa)\n",
+                temp_c, pressure_hpa);
+        return -1;
+    }
+
+    memset(a, 0, sizeof(*a));
+    a->temp_c = temp_c;
+    a->pressure_hpa = pressure_hpa;
+
+    double h_min = sin(DEG2RAD_D(ATMOS_MIN_ALT_DEG));
+    double step = (1.0 - h_min) / ATMOS_TABLE;
+    a->h_min = (float)h_min;
+    a->inv_step = (float)(1.0 / step);
+    a->h_visible = 1.0f;
+
+    // Rayleigh and aerosol extinction both thin out with pressure
+    double k = ATMOS_K_V * (pressure_hpa / 1013.25);
+
+    double prev_h = h_min, prev_app = -1.0;
+    for (int i = 0; i <= ATMOS_TABLE; i++)
+    {
+        double h = (i == ATMOS_TABLE) ? 1.0 : h_min + step * i;
+        double alt = RAD2DEG_D(asin(h));
+        double r = refraction_deg(alt, temp_c, pressure_hpa);
+        double app = alt + r;
+
+        // v' = v cos r + t sin r, with t = (Up - h v) / cos(alt) the
+        // unit tangent toward the zenith
+        double cos_alt = sqrt(1.0 - h*h);
+        double s = (cos_alt > 1e-6) ? sin(DEG2RAD_D(r)) / cos_alt : 0.0;
+        a->lift_a[i] = (float)(cos(DEG2RAD_D(r)) - h * s);
+        a->lift_b[i] = (float)s;
+
+        double dm = k * (airmass(app) - 1.0);
+        a->dmag[i] = (float)((dm > 0.0) ? dm : 0.0);
+
+        // Where the apparent altitude crosses zero
+        if (app >= 0.0 && prev_app < 0.0)
+        {
+            double t = (i > 0) ? -prev_app / (app - prev_app) : 0.0;
+            a->h_visible = (float)(prev_h + t * (h - prev_h));
+        }
+        prev_h = h;
+        prev_app = app;
+    }
+
+    return 0;
+}
+
+void atmos_lookup(const atmos_t *a, float h, float *wa, float *wb, float *dmag)
+{
+    float f = (h - a->h_min) * a->inv_step;
+    if (f < 0.0f)
+    {
+        f = 0.0f;
+    }
+
+    int i = (int)f;
+    if (i >= ATMOS_TABLE)
+    {
+        i = ATMOS_TABLE - 1;
+    }
+    float t = f - (float)i;
+
+    *wa = a->lift_a[i] + t * (a->lift_a[i + 1] - a->lift_a[i]);
+    *wb = a->lift_b[i] + t * (a->lift_b[i + 1] - a->lift_b[i]);
+    *dmag = a->dmag[i] + t * (a->dmag[i + 1] - a->dmag[i]);
+}
@@ -0,0 +1,287 @@
+#include "constellations.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Segments with an end this close to 90 deg off-axis are skipped.
+// Figure segments are well under 45 deg long, so the other end is
+// then off screen too.
+#define CONST_NEAR 0.05f
+
+typedef struct
+{
+    const char *name;
+    uint32_t idx;
+} name_ref_t;
+
+static int cmp_name(const void *a, const void *b)
+{
+    return strcmp(((const name_ref_t*)a)->name, ((const name_ref_t*)b)->name);
+}
+
+// Catalog index for name, or -1
+static long find_star(const name_ref_t *names, size_t n, const char *name)
+{
+    name_ref_t key = {name, 0};
+    const name_ref_t *r = (const name_ref_t*)bsearch(&key, names, n, sizeof(name_ref_t), cmp_name);
+    return r ? (long)r->idx : -1;
+}
+
+// Strips leading/trailing blanks and the line ending in place
+static char *trim(char *s)
+{
+    while (*s == ' ' || *s == '\t') s++;
+
+    char *e = s + strlen(s);
+    while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\n' || e[-1] == '\r'))
+    {
+        *--e = '\0';
+    }
+    return s;
+}
+
+static int add_segment(constellations_t *c, size_t *cap, uint32_t a, uint32_t b)
+{
+    if (c->n_seg >= *cap)
+    {
+        size_t newcap = (*cap == 0) ? 256 : *cap * 2;
+        uint32_t *p = (uint32_t*)realloc(c->seg, newcap * 2 * sizeof(uint32_t));
+        if (!p)
+        {
+            return -1;
+        }
+
+        c->seg = p;
+        *cap = newcap;
+    }
+
+    c->seg[2 * c->n_seg] = a;
+    c->seg[2 * c->n_seg + 1] = b;
+    c->n_seg++;
+    return 0;
+}
+
+void constellations_free(constellations_t *c)
+{
+    if (!c)
+    {
+        return;
+    }
+
+    free(c->seg);
+    linebatch_free(&c->batch);
+    memset(c, 0, sizeof(*c));
+}
+
+int constellations_load(constellations_t *c, const star_catalog_t *cat, const char *path)
+{
+    if (!c || !cat || !path)
+    {
+        return -1;
+    }
+
+    memset(c, 0, sizeof(*c));
+
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+    {
+        perror("fopen constellations");
+        return -1;
+    }
+
+    // Name -> catalog index, sorted for binary search
+    size_t n_names = cat->count;
+    name_ref_t *names = (name_ref_t*)malloc(sizeof(name_ref_t) * (n_names ? n_names : 1));
+    if (!names || linebatch_init(&c->batch, CONST_LINE_WIDTH) != 0)
+    {
+        free(names);
+        fclose(fp);
+        constellations_free(c);
+        return -1;
+    }
+
+    for (size_t i = 0; i < n_names; i++)
+    {
+        names[i].name = stars_name(cat, i);
+        names[i].idx = (uint32_t)i;
+    }
+    qsort(names, n_names, sizeof(name_ref_t), cmp_name);
+
+    size_t cap = 0;
+    char line[1024];
+    char prev_abbr[16] = "";
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        char *s = trim(line);
+        if (*s == '\0' || *s == '#')
+        {
+            continue;
+        }
+
+        // abbr,star,star[,star...]: a polyline through the named stars
+        char *field = strtok(s, ",");
+        if (!field)
+        {
+            continue;
+        }
+
+        char *abbr = trim(field);
+        if (strcmp(abbr, prev_abbr) != 0)
+        {
+            c->n_figures++;
+            snprintf(prev_abbr, sizeof(prev_abbr), "%s", abbr);
+        }
+
+        long prev = -2;     // -2: no previous star on this line
+        while ((field = strtok(NULL, ",")) != NULL)
+        {
+            char *name = trim(field);
+            long idx = find_star(names, n_names, name);
+            if (idx < 0)
+            {
+                fprintf(stderr, "constellations: %s: no star named %s\n", abbr, name);
+            }
+
+            if (prev != -2)
+            {
+                if (prev < 0 || idx < 0)
+                {
+                    c->n_missing++;
+                }
+                else if (add_segment(c, &cap, (uint32_t)prev, (uint32_t)idx) != 0)
+                {
+                    free(names);
+                    fclose(fp);
+                    constellations_free(c);
+                    return -1;
+                }
+            }
+            prev = idx;
+        }
+    }
+
+    free(names);
+    fclose(fp);
+    return 0;
+}
+
+static void screen_pt(const camera_t *cam, const float p[3], float cz, float *x, float *y)
+{
+    float inv = cam->focal / cz;
+    *x = (cam->rx*p[0] + cam->ry*p[1] + cam->rz*p[2]) * inv + cam->cx;
+    *y = -(cam->ux*p[0] + cam->uy*p[1] + cam->uz*p[2]) * inv + cam->cy;
+}
+
+// Point where the arc a -> b meets the horizon (ha and hb have opposite signs)
+static void horizon_pt(const float a[3], const float b[3], float ha, float hb, float out[3])
+{
+    float t = ha / (ha - hb);
+    for (int k = 0; k < 3; k++)
+    {
+        out[k] = a[k] + t * (b[k] - a[k]);
+    }
+
+    float n = sqrtf(out[0]*out[0] + out[1]*out[1] + out[2]*out[2]);
+    if (n > 1e-6f)
+    {
+        out[0] /= n;
+        out[1] /= n;
+        out[2] /= n;
+    }
+}
+
+// Refraction lift toward Up for a point at sin(altitude) h
+static void lift(const atmos_t *atm, float p[3], float h, float zx, float zy, float zz)
+{
+    float wa, wb, dmag;
+    atmos_lookup(atm, h, &wa, &wb, &dmag);
+    p[0] = wa*p[0] + wb*zx;
+    p[1] = wa*p[1] + wb*zy;
+    p[2] = wa*p[2] + wb*zz;
+}
+
+int constellations_draw(constellations_t *c, SDL_Renderer *ren, const star_cache_buf_t *sc,
+                        const camera_t *cam, float zx, float zy, float zz,
+                        const atmos_t *atm, SDL_Color color)
+{
+    c->n_drawn = 0;
+
+    if (!sc || c->n_seg == 0)
+    {
+        return 0;
+    }
+
+    linebatch_begin(&c->batch);
+
+    for (size_t s = 0; s < c->n_seg; s++)
+    {
+        uint32_t ia = c->seg[2*s];
+        uint32_t ib = c->seg[2*s + 1];
+        if (ia >= sc->count || ib >= sc->count)
+        {
+            continue;
+        }
+
+        float a[3] = {sc->ex[ia], sc->ey[ia], sc->ez[ia]};
+        float b[3] = {sc->ex[ib], sc->ey[ib], sc->ez[ib]};
+
+        // Cut at the horizon
+        float ha = a[0]*zx + a[1]*zy + a[2]*zz;
+        float hb = b[0]*zx + b[1]*zy + b[2]*zz;
+        if (ha < 0.0f && hb < 0.0f)
+        {
+            continue;
+        }
+        if (ha < 0.0f)
+        {
+            horizon_pt(a, b, ha, hb, a);
+            ha = 0.0f;
+        }
+        else if (hb < 0.0f)
+        {
+            horizon_pt(a, b, ha, hb, b);
+            hb = 0.0f;
+        }
+
+        if (atm)
+        {
+            lift(atm, a, ha, zx, zy, zz);
+            lift(atm, b, hb, zx, zy, zz);
+        }
+
+        // Both ends outside one side plane: the whole arc is
+        int outside = 0;
+        for (int p = 0; p < 4 && !outside; p++)
+        {
+            const float *n = cam->planes[p];
+            outside = (n[0]*a[0] + n[1]*a[1] + n[2]*a[2] < 0.0f &&
+                       n[0]*b[0] + n[1]*b[1] + n[2]*b[2] < 0.0f);
+        }
+        if (outside)
+        {
+            continue;
+        }
+
+        float za = cam->fx*a[0] + cam->fy*a[1] + cam->fz*a[2];
+        float zb = cam->fx*b[0] + cam->fy*b[1] + cam->fz*b[2];
+        if (za <= CONST_NEAR || zb <= CONST_NEAR)
+        {
+            continue;
+        }
+
+        float x0, y0, x1, y1;
+        screen_pt(cam, a, za, &x0, &y0);
+        screen_pt(cam, b, zb, &x1, &y1);
+
+        if (linebatch_segment(&c->batch, x0, y0, x1, y1, color) != 0)
+        {
+            break;
+        }
+        c->n_drawn++;
+    }
+
+    // All visible segments in one call
+    return linebatch_flush(&c->batch, ren);
+}
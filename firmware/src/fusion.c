@@ -0,0 +1,178 @@
+#include "fusion.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEG2RAD_F(x) ((float)(x) * ((float)M_PI / 180.0f))
+
+// Sensor axes -> body axes (identity for the reference mounting)
+static void sensor_to_body(const imu_raw_t *raw, float a[3], float g[3])
+{
+    a[0] = raw->ax;
+    a[1] = raw->ay;
+    a[2] = raw->az;
+
+    g[0] = DEG2RAD_F(raw->gx);
+    g[1] = DEG2RAD_F(raw->gy);
+    g[2] = DEG2RAD_F(raw->gz);
+}
+
+// Returns 0 and normalizes a, or -1 if there is no usable gravity vector
+static int normalize3(float a[3])
+{
+    float n = sqrtf(a[0]*a[0] + a[1]*a[1] + a[2]*a[2]);
+    if (n < 1e-6f)
+    {
+        return -1;
+    }
+
+    a[0] /= n;
+    a[1] /= n;
+    a[2] /= n;
+    return 0;
+}
+
+/*
+ * Attitude with heading 0 whose body Z lines up with the measured
+ * gravity reaction: the shortest rotation taking body `a` onto local Up.
+ */
+static quat_t level_from_accel(const float a[3])
+{
+    // Rotation from a to (0,0,1): axis a x up, cos angle = a.z
+    float w = 1.0f + a[2];
+    if (w < 1e-6f)
+    {
+        // Upside down: half turn about X
+        quat_t q = {0.0f, 1.0f, 0.0f, 0.0f};
+        return q;
+    }
+
+    quat_t q = {w, a[1], -a[0], 0.0f};
+    return orient_quat_normalize(q);
+}
+
+void fusion_init(fusion_t *f, float kp, float ki)
+{
+    f->q = orient_quat_identity();
+    f->kp = kp;
+    f->ki = ki;
+    f->bx = f->by = f->bz = 0.0f;
+    f->initialized = 0;
+}
+
+void fusion_update(fusion_t *f, const imu_raw_t *raw, float dt)
+{
+    float a[3], g[3];
+    sensor_to_body(raw, a, g);
+
+    int have_accel = (normalize3(a) == 0);
+
+    if (!f->initialized)
+    {
+        if (have_accel)
+        {
+            f->q = level_from_accel(a);
+            f->initialized = 1;
+        }
+        return;
+    }
+
+    quat_t q = f->q;
+
+    if (have_accel)
+    {
+        // Gravity reaction predicted in the body frame: R^T * (0, 0, 1)
+        float vx = 2.0f * (q.x*q.z - q.w*q.y);
+        float vy = 2.0f * (q.w*q.x + q.y*q.z);
+        float vz = q.w*q.w - q.x*q.x - q.y*q.y + q.z*q.z;
+
+        // Error is the rotation between measured and predicted
+        float ex = a[1]*vz - a[2]*vy;
+        float ey = a[2]*vx - a[0]*vz;
+        float ez = a[0]*vy - a[1]*vx;
+
+        if (f->ki > 0.0f)
+        {
+            f->bx += f->ki * ex * dt;
+            f->by += f->ki * ey * dt;
+            f->bz += f->ki * ez * dt;
+        }
+
+        g[0] += f->kp * ex + f->bx;
+        g[1] += f->kp * ey + f->by;
+        g[2] += f->kp * ez + f->bz;
+    }
+
+    // q' = 0.5 * q * (0, g)
+    float hx = 0.5f * g[0] * dt;
+    float hy = 0.5f * g[1] * dt;
+    float hz = 0.5f * g[2] * dt;
+
+    quat_t d;
+    d.w = -q.x*hx - q.y*hy - q.z*hz;
+    d.x =  q.w*hx + q.y*hz - q.z*hy;
+    d.y =  q.w*hy - q.x*hz + q.z*hx;
+    d.z =  q.w*hz + q.x*hy - q.y*hx;
+
+    q.w += d.w;
+    q.x += d.x;
+    q.y += d.y;
+    q.z += d.z;
+
+    f->q = orient_quat_normalize(q);
+}
+
+void fusion_rate(const fusion_t *f, const imu_raw_t *raw, float *wx, float *wy, float *wz)
+{
+    float a[3], g[3];
+    sensor_to_body(raw, a, g);
+
+    *wx = g[0] + f->bx;
+    *wy = g[1] + f->by;
+    *wz = g[2] + f->bz;
+}
+
+// Exact rotation for a constant rate: angle |w| dt about w
+static quat_t rotate_by_rate(quat_t q, float wx, float wy, float wz, float dt)
+{
+    float w = sqrtf(wx*wx + wy*wy + wz*wz);
+    if (w < 1e-6f)
+    {
+        return q;
+    }
+
+    float half = 0.5f * w * dt;
+    float s = sinf(half) / w;
+    quat_t d = {cosf(half), wx * s, wy * s, wz * s};
+
+    // Body-frame rate: applied on the right
+    return orient_quat_normalize(orient_quat_mul(q, d));
+}
+
+quat_t fusion_predict(quat_t q, float wx, float wy, float wz, float dt)
+{
+    if (dt <= 0.0f)
+    {
+        return q;
+    }
+    if (dt > FUSION_PREDICT_MAX_S)
+    {
+        dt = FUSION_PREDICT_MAX_S;
+    }
+
+    return rotate_by_rate(q, wx, wy, wz, dt);
+}
+
+void fusion_bridge(fusion_t *f, const imu_raw_t *raw, float gap)
+{
+    if (!f->initialized || gap <= 0.0f)
+    {
+        return;
+    }
+
+    float wx, wy, wz;
+    fusion_rate(f, raw, &wx, &wy, &wz);
+    f->q = rotate_by_rate(f->q, wx, wy, wz, gap);
+}
@@ -0,0 +1,303 @@
+#include "grid.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEG2RAD_F(x) ((float)(x) * ((float)M_PI / 180.0f))
+#define TWO_PI_F (2.0f * (float)M_PI)
+#define STEP_RAD DEG2RAD_F(GRID_STEP_DEG)
+
+// Visible pieces of one circle (the view cone and the horizon each
+// cut an arc into at most two)
+#define GRID_MAX_SPANS 8
+
+typedef struct
+{
+    float lo, hi;
+} span_t;
+
+static float dot3(const float a[3], const float b[3])
+{
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// Circle about the frame's Z axis at height h, t measured from u toward v
+static void add_circle(sky_grid_t *g, float h, float rho,
+                       float ux, float uy, float uz,
+                       float vx, float vy, float vz, float t0, float t1)
+{
+    if (g->first[GRID_LAYER_COUNT] >= GRID_MAX_CIRCLES)
+    {
+        return;
+    }
+
+    grid_circle_t *c = &g->circles[g->first[GRID_LAYER_COUNT]++];
+    c->c[0] = 0.0f;
+    c->c[1] = 0.0f;
+    c->c[2] = h;
+    c->rho = rho;
+    c->u[0] = ux; c->u[1] = uy; c->u[2] = uz;
+    c->v[0] = vx; c->v[1] = vy; c->v[2] = vz;
+    c->t0 = t0;
+    c->t1 = t1;
+}
+
+static void begin_layer(sky_grid_t *g, grid_layer_t l)
+{
+    g->first[l] = g->first[GRID_LAYER_COUNT];
+}
+
+void grid_free(sky_grid_t *g)
+{
+    if (!g)
+    {
+        return;
+    }
+
+    free(g->pts);
+    linebatch_free(&g->batch);
+    memset(g, 0, sizeof(*g));
+}
+
+int grid_init(sky_grid_t *g)
+{
+    if (!g)
+    {
+        return -1;
+    }
+
+    memset(g, 0, sizeof(*g));
+
+    for (int k = 0; k < GRID_TABLE; k++)
+    {
+        g->cos_t[k] = cosf((float)k * STEP_RAD);
+        g->sin_t[k] = sinf((float)k * STEP_RAD);
+    }
+
+    // Local frame: x = East, y = North, z = Up; t = azimuth or altitude
+    begin_layer(g, GRID_HORIZON);
+    add_circle(g, 0.0f, 1.0f, 0, 1, 0, 1, 0, 0, 0.0f, TWO_PI_F);
+
+    begin_layer(g, GRID_ALTAZ);
+    for (int alt = GRID_ALT_STEP_DEG; alt < 90; alt += GRID_ALT_STEP_DEG)
+    {
+        add_circle(g, sinf(DEG2RAD_F(alt)), cosf(DEG2RAD_F(alt)),
+                   0, 1, 0, 1, 0, 0, 0.0f, TWO_PI_F);
+    }
+    for (int az = 0; az < 360; az += GRID_AZ_STEP_DEG)
+    {
+        add_circle(g, 0.0f, 1.0f, sinf(DEG2RAD_F(az)), cosf(DEG2RAD_F(az)), 0,
+                   0, 0, 1, 0.0f, 0.5f * (float)M_PI);
+    }
+
+    // Equatorial frame: z = celestial pole; t = RA or declination
+    begin_layer(g, GRID_RADEC);
+    for (int dec = -90 + GRID_DEC_STEP_DEG; dec < 90; dec += GRID_DEC_STEP_DEG)
+    {
+        if (dec == 0)
+        {
+            continue;
+        }
+        add_circle(g, sinf(DEG2RAD_F(dec)), cosf(DEG2RAD_F(dec)),
+                   1, 0, 0, 0, 1, 0, 0.0f, TWO_PI_F);
+    }
+    for (int ra = 0; ra < 24; ra += GRID_RA_STEP_H)
+    {
+        float a = DEG2RAD_F(ra * 15);
+        add_circle(g, 0.0f, 1.0f, cosf(a), sinf(a), 0,
+                   0, 0, 1, -0.5f * (float)M_PI, 0.5f * (float)M_PI);
+    }
+
+    begin_layer(g, GRID_EQUATOR);
+    add_circle(g, 0.0f, 1.0f, 1, 0, 0, 0, 1, 0, 0.0f, TWO_PI_F);
+
+    // One arc spans at most a full turn of table points plus its ends
+    g->pts_cap = GRID_TABLE + 3;
+    g->pts = (float*)malloc(sizeof(float) * 2 * (size_t)g->pts_cap);
+
+    if (!g->pts || linebatch_init(&g->batch, GRID_LINE_WIDTH) != 0)
+    {
+        fprintf(stderr, "grid: out of memory\n");
+        grid_free(g);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Keeps the parts of spans s where the circle satisfies n.p >= k.
+ *
+ * n.p(t) = A + B cos(t - phi), so the condition holds on a single arc
+ * phi +- acos((k - A) / B). Returns the new span count.
+ */
+static int cut_spans(span_t *s, int n, const grid_circle_t *c, const float nrm[3], float k)
+{
+    float a = dot3(nrm, c->c);
+    float nu = dot3(nrm, c->u);
+    float nv = dot3(nrm, c->v);
+    float b = c->rho * sqrtf(nu*nu + nv*nv);
+
+    if (b < 1e-6f)
+    {
+        return (a >= k) ? n : 0;
+    }
+
+    float x = (k - a) / b;
+    if (x <= -1.0f)
+    {
+        return n;
+    }
+    if (x >= 1.0f)
+    {
+        return 0;
+    }
+
+    float phi = atan2f(nv, nu);
+    float half = acosf(x);
+
+    span_t in[GRID_MAX_SPANS];
+    memcpy(in, s, sizeof(span_t) * (size_t)n);
+
+    int out = 0;
+    for (int i = 0; i < n; i++)
+    {
+        // The arc may sit a turn either side of the span
+        for (int turn = -1; turn <= 1; turn++)
+        {
+            float lo = phi - half + (float)turn * TWO_PI_F;
+            float hi = phi + half + (float)turn * TWO_PI_F;
+
+            if (lo < in[i].lo) lo = in[i].lo;
+            if (hi > in[i].hi) hi = in[i].hi;
+
+            if (hi > lo && out < GRID_MAX_SPANS)
+            {
+                s[out].lo = lo;
+                s[out].hi = hi;
+                out++;
+            }
+        }
+    }
+    return out;
+}
+
+// Screen position of circle point (cos t, sin t); 0 if behind the camera
+static int project_pt(const grid_circle_t *c, const camera_t *cam, float ct, float st,
+                      float *out)
+{
+    float x = c->c[0] + c->rho * (c->u[0]*ct + c->v[0]*st);
+    float y = c->c[1] + c->rho * (c->u[1]*ct + c->v[1]*st);
+    float z = c->c[2] + c->rho * (c->u[2]*ct + c->v[2]*st);
+
+    float cz = cam->fx*x + cam->fy*y + cam->fz*z;
+    if (cz <= 1e-4f)
+    {
+        return 0;
+    }
+
+    float inv = cam->focal / cz;
+    out[0] = (cam->rx*x + cam->ry*y + cam->rz*z) * inv + cam->cx;
+    out[1] = -(cam->ux*x + cam->uy*y + cam->uz*z) * inv + cam->cy;
+    return 1;
+}
+
+static void emit_strip(sky_grid_t *g, int n_pts, SDL_Color color)
+{
+    if (n_pts >= 2 && linebatch_strip(&g->batch, g->pts, n_pts, color) == 0)
+    {
+        g->n_points += n_pts;
+    }
+}
+
+// Samples t in [lo, hi]: exact end points, table points in between
+static void emit_span(sky_grid_t *g, const grid_circle_t *c, const camera_t *cam,
+                      span_t sp, SDL_Color color)
+{
+    int n = 0;
+    int k0 = (int)ceilf(sp.lo / STEP_RAD);
+    int k1 = (int)floorf(sp.hi / STEP_RAD);
+
+    for (int k = k0 - 1; k <= k1 + 1 && n < g->pts_cap; k++)
+    {
+        float ct, st;
+        if (k < k0)
+        {
+            ct = cosf(sp.lo);
+            st = sinf(sp.lo);
+        }
+        else if (k > k1)
+        {
+            ct = cosf(sp.hi);
+            st = sinf(sp.hi);
+        }
+        else
+        {
+            int m = ((k % GRID_TABLE) + GRID_TABLE) % GRID_TABLE;
+            ct = g->cos_t[m];
+            st = g->sin_t[m];
+        }
+
+        if (project_pt(c, cam, ct, st, &g->pts[2*n]))
+        {
+            n++;
+        }
+        else
+        {
+            // Only reachable without the cone cut; break the line
+            emit_strip(g, n, color);
+            n = 0;
+        }
+    }
+
+    emit_strip(g, n, color);
+}
+
+int grid_draw(sky_grid_t *g, SDL_Renderer *ren, grid_layer_t layer,
+              const camera_t *cam, float zx, float zy, float zz, SDL_Color color)
+{
+    g->n_arcs = 0;
+    g->n_points = 0;
+
+    if (layer < 0 || layer >= GRID_LAYER_COUNT)
+    {
+        return -1;
+    }
+
+    const float fwd[3] = {cam->fx, cam->fy, cam->fz};
+    const float up[3] = {zx, zy, zz};
+    const float cone_k = cosf(DEG2RAD_F(cam->half_angle_deg));
+    const int clip_horizon = (zx != 0.0f || zy != 0.0f || zz != 0.0f);
+
+    linebatch_begin(&g->batch);
+
+    for (int i = g->first[layer]; i < g->first[layer + 1]; i++)
+    {
+        const grid_circle_t *c = &g->circles[i];
+
+        span_t spans[GRID_MAX_SPANS];
+        spans[0].lo = c->t0;
+        spans[0].hi = c->t1;
+        int n = 1;
+
+        n = cut_spans(spans, n, c, fwd, cone_k);
+        if (clip_horizon && n > 0)
+        {
+            n = cut_spans(spans, n, c, up, 0.0f);
+        }
+
+        for (int s = 0; s < n; s++)
+        {
+            emit_span(g, c, cam, spans[s], color);
+        }
+        g->n_arcs += n;
+    }
+
+    // Disjoint arcs in one call (SDL_RenderDrawLines can only do one polyline)
+    return linebatch_flush(&g->batch, ren);
+}
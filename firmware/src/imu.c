@@ -1,6 +1,8 @@
 #include "imu.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <math.h>
+#include <stddef.h>
 
 /*
  * Linux builds (Raspberry Pi) use real I2C access.
@@ -11,8 +13,8 @@
     #include <unistd.h>
     #include <fcntl.h>
     #include <sys/ioctl.h>
+    #include <linux/i2c.h>
     #include <linux/i2c-dev.h>
-    #include <math.h>
 #endif
 
 /*
@@ -20,12 +22,69 @@
  * These values come from the MPU6050 datasheet
  * */
 #define MPU6050_ADDR         0x68
-#define MPU6050_PWR_MGMT_1   0x6B
+#define MPU6050_SMPLRT_DIV   0x19
+#define MPU6050_CONFIG       0x1A
+#define MPU6050_GYRO_CONFIG  0x1B
+#define MPU6050_ACCEL_CONFIG 0x1C
+#define MPU6050_FIFO_EN      0x23
 #define MPU6050_ACCEL_XOUT_H 0x3B
+#define MPU6050_USER_CTRL    0x6A
+#define MPU6050_PWR_MGMT_1   0x6B
+#define MPU6050_FIFO_COUNTH  0x72
+#define MPU6050_FIFO_R_W     0x74
+
+#define MPU6050_FIFO_EN_ACCEL_GYRO  0x78    // XG, YG, ZG, ACCEL
+#define MPU6050_USER_CTRL_FIFO_EN   0x40
+#define MPU6050_USER_CTRL_FIFO_RST  0x04
+#define MPU6050_FIFO_SIZE           1024
+
+// FIFO packet: accel XYZ then gyro XYZ, big-endian int16 each
+#define IMU_FIFO_PACKET 12
 
 // File descriptor for /dev/i2c-1 (Linux only)
 static int i2c_fd = -1;
 
+#ifdef __linux__
+// Set while an overflow reset still has to reach the chip; until it
+// does, the FIFO contents are misaligned and must not be read
+static int fifo_reset_pending = 0;
+
+/*
+ * Register read as one combined I2C_RDWR transaction
+ * (register select + repeated-start read): one syscall per burst.
+ */
+static int i2c_read_regs(uint8_t reg, uint8_t *buf, uint16_t len)
+{
+    struct i2c_msg msgs[2] = {
+        { MPU6050_ADDR, 0,        1,   &reg },
+        { MPU6050_ADDR, I2C_M_RD, len, buf  }
+    };
+    struct i2c_rdwr_ioctl_data xfer = { msgs, 2 };
+
+    return (ioctl(i2c_fd, I2C_RDWR, &xfer) == 2) ? 0 : -1;
+}
+
+static int i2c_write_reg(uint8_t reg, uint8_t val)
+{
+    uint8_t buf[2] = {reg, val};
+    return (write(i2c_fd, buf, 2) == 2) ? 0 : -1;
+}
+#endif
+
+// Big-endian sample (accel XYZ, gyro XYZ) to g's and deg/s
+static void unpack_raw(const uint8_t *a, const uint8_t *g, imu_raw_t *r)
+{
+    // Convert raw accel to g's (+/- 2g)
+    r->ax = (int16_t)((a[0] << 8) | a[1]) / 16384.0f;
+    r->ay = (int16_t)((a[2] << 8) | a[3]) / 16384.0f;
+    r->az = (int16_t)((a[4] << 8) | a[5]) / 16384.0f;
+
+    // Convert gyro to deg/s (+/- 250 deg/s)
+    r->gx = (int16_t)((g[0] << 8) | g[1]) / 131.0f;
+    r->gy = (int16_t)((g[2] << 8) | g[3]) / 131.0f;
+    r->gz = (int16_t)((g[4] << 8) | g[5]) / 131.0f;
+}
+
 /*
  * Initializes the MPU 6050 over I2C
  * - Opens /dev/i2c-1
@@ -74,7 +133,36 @@ int imu_init(void)
 
 /*
  * Reads raw accelerometer and gyroscope data from the MPU6050
- * and converts it into pitch, roll, and yaw values.
+ * in one 14-byte burst and converts it to g's and deg/s.
+ */
+int imu_read_raw(imu_raw_t *r)
+{
+    if (!r) return -1;
+
+#ifdef __linux__
+
+    if (i2c_fd < 0)
+    {
+        return -1;
+    }
+
+    // Read 14 bytes: accel, temp, gyro
+    uint8_t data[14];
+    if (i2c_read_regs(MPU6050_ACCEL_XOUT_H, data, sizeof(data)) != 0)
+    {
+        return -1;
+    }
+
+    unpack_raw(&data[0], &data[8], r);
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Converts one raw sample into pitch, roll, and yaw values.
  * 
  * Pitch/Roll:
  *  Derived from accelerometer using trigonometry.
@@ -82,56 +170,162 @@ int imu_init(void)
  * Yaw:
  *  Currently a placeholder derived from gyro Z-axis.
  */
+void imu_raw_to_angles(const imu_raw_t *r, imu_data_t *d)
+{
+    d->pitch = atan2f(r->ax, sqrtf(r->ay*r->ay + r->az*r->az)) * 57.2958f;
+    d->roll  = atan2f(r->ay, sqrtf(r->ax*r->ax + r->az*r->az)) * 57.2958f;
+    d->yaw   = r->gz;   // placeholder
+}
+
 int imu_read(imu_data_t *d)
 {
     if (!d) return -1;
 
-#ifdef __linux__
+    imu_raw_t r;
+    if (imu_read_raw(&r) != 0)
+    {
+        return -1;
+    }
+
+    imu_raw_to_angles(&r, d);
+    return 0;
+}
 
+void imu_default_config(imu_config_t *cfg)
+{
+    cfg->sample_rate_hz = 250;
+    cfg->dlpf_cfg = 3;          // ~44 Hz accel / 42 Hz gyro bandwidth
+    cfg->use_fifo = 1;
+}
+
+/*
+ * Programs the low-pass filter, sample rate divider and full-scale
+ * ranges, and optionally starts the FIFO with accel + gyro packets.
+ *
+ * Sample rate = gyro output rate / (1 + SMPLRT_DIV), where the gyro
+ * output rate is 1 kHz with the DLPF on (cfg 1..6) and 8 kHz with it
+ * off. The accelerometer itself never updates faster than 1 kHz.
+ */
+int imu_configure(const imu_config_t *cfg)
+{
+    if (!cfg || cfg->sample_rate_hz <= 0 || cfg->dlpf_cfg < 0 || cfg->dlpf_cfg > 6)
+    {
+        return -1;
+    }
+
+#ifdef __linux__
     if (i2c_fd < 0)
     {
         return -1;
     }
 
-    // Select starting register
-    uint8_t reg = MPU6050_ACCEL_XOUT_H;
-    if (write(i2c_fd, &reg, 1) != 1)
+    int base_hz = (cfg->dlpf_cfg == 0) ? 8000 : 1000;
+    int div = base_hz / cfg->sample_rate_hz - 1;
+    if (div < 0)   div = 0;
+    if (div > 255) div = 255;
+
+    // FIFO off while the rate changes, so no packet straddles the switch
+    if (i2c_write_reg(MPU6050_FIFO_EN, 0) != 0 ||
+        i2c_write_reg(MPU6050_USER_CTRL, 0) != 0 ||
+        i2c_write_reg(MPU6050_CONFIG, (uint8_t)cfg->dlpf_cfg) != 0 ||
+        i2c_write_reg(MPU6050_SMPLRT_DIV, (uint8_t)div) != 0 ||
+        i2c_write_reg(MPU6050_GYRO_CONFIG, 0) != 0 ||     // +/- 250 deg/s
+        i2c_write_reg(MPU6050_ACCEL_CONFIG, 0) != 0)      // +/- 2 g
     {
+        perror("imu_configure");
         return -1;
     }
 
-    // Read 14 bytes: accel, temp, gyro
-    uint8_t data[14];
-    if (read(i2c_fd, data, 14) != 14)
+    if (cfg->use_fifo)
+    {
+        if (i2c_write_reg(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RST) != 0 ||
+            i2c_write_reg(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN) != 0 ||
+            i2c_write_reg(MPU6050_FIFO_EN, MPU6050_FIFO_EN_ACCEL_GYRO) != 0)
+        {
+            perror("imu_configure FIFO");
+            return -1;
+        }
+        fifo_reset_pending = 0;
+    }
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Drains up to max queued samples from the FIFO, oldest first:
+ * one transaction for the byte count, one for all the packets.
+ * On overflow the FIFO is reset (its packet alignment is lost) and
+ * IMU_FIFO_OVERFLOW is returned so the caller can account for the
+ * lost time. If the reset write fails, the next call retries it
+ * before reading any packet.
+ */
+int imu_read_fifo(imu_raw_t *out, size_t max)
+{
+    if (!out)
     {
         return -1;
     }
 
-    // Raw accelerometer values
-    int16_t ax = (data[0] << 8) | data[1];
-    int16_t ay = (data[2] << 8) | data[3];
-    int16_t az = (data[4] << 8) | data[5];
+#ifdef __linux__
+    if (i2c_fd < 0)
+    {
+        return -1;
+    }
 
-    // Raw gyroscope values
-    int16_t gx = (data[8] << 8) | data[9];
-    int16_t gy = (data[10] << 8) | data[11];
-    int16_t gz = (data[12] << 8) | data[13];
+    if (fifo_reset_pending)
+    {
+        if (i2c_write_reg(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RST | MPU6050_USER_CTRL_FIFO_EN) != 0)
+        {
+            return -1;
+        }
+        fifo_reset_pending = 0;
+    }
 
-    // Convert raw accel to g's (+/- 2g)
-    float axg = ax / 16384.0f;
-    float ayg = ay / 16384.0f;
-    float azg = az / 16384.0f;
+    uint8_t hdr[2];
+    if (i2c_read_regs(MPU6050_FIFO_COUNTH, hdr, 2) != 0)
+    {
+        return -1;
+    }
 
-    // Convert gyro to deg/s (+/- 250 deg/s)
-    float gzds = gz / 131.0f;
+    // A full FIFO has overflowed: the oldest bytes were discarded, so
+    // packet boundaries no longer line up with the read position
+    unsigned count = ((unsigned)hdr[0] << 8) | hdr[1];
+    if (count >= MPU6050_FIFO_SIZE)
+    {
+        // A failed reset is retried before the next drain reads anything
+        if (i2c_write_reg(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RST | MPU6050_USER_CTRL_FIFO_EN) != 0)
+        {
+            fifo_reset_pending = 1;
+        }
+        return IMU_FIFO_OVERFLOW;
+    }
 
-    // Compute orientation angles
-    d->pitch = atan2f(axg, sqrtf(ayg*ayg + azg*azg)) * 57.2958f;
-    d->roll  = atan2f(ayg, sqrtf(axg*axg + azg*azg)) * 57.2958f;
-    d->yaw   = gzds;    // placeholder
+    size_t n = count / IMU_FIFO_PACKET;
+    if (n > max)                n = max;
+    if (n > IMU_FIFO_MAX_BATCH) n = IMU_FIFO_MAX_BATCH;
+    if (n == 0)
+    {
+        return 0;
+    }
 
-    return 0;
+    uint8_t data[IMU_FIFO_MAX_BATCH * IMU_FIFO_PACKET];
+    if (i2c_read_regs(MPU6050_FIFO_R_W, data, (uint16_t)(n * IMU_FIFO_PACKET)) != 0)
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint8_t *p = &data[i * IMU_FIFO_PACKET];
+        unpack_raw(&p[0], &p[6], &out[i]);
+    }
+
+    return (int)n;
 #else
+    (void)max;
     return -1;
 #endif
 }
@@ -148,23 +342,31 @@ void imu_close(void)
 #endif
 }
 
+// Simulated orientation state
+static float sim_yaw = 0.f;
+static float sim_pitch = 0.f;
+static float sim_roll = 0.f;
+
 void imu_sim_step(imu_data_t *d, float dt)
 {
-    static float yaw = 0.f;
-    static float pitch = 0.f;
-    static float roll = 0.f;
-
     if (!d) return;
 
-    yaw += 30.f * dt;
-    pitch += 20.f * dt;
-    roll += 15.f * dt;
+    sim_yaw += 30.f * dt;
+    sim_pitch += 20.f * dt;
+    sim_roll += 15.f * dt;
 
-    if (yaw > 360.f)    yaw -= 360.f;
-    if (pitch > 360.f)  pitch -= 360.f;
-    if (roll > 360.f)   roll -= 360.f;
+    if (sim_yaw > 360.f)    sim_yaw -= 360.f;
+    if (sim_pitch > 360.f)  sim_pitch -= 360.f;
+    if (sim_roll > 360.f)   sim_roll -= 360.f;
 
-    d->yaw = yaw;
-    d->pitch = pitch;
-    d->roll = roll;
+    d->yaw = sim_yaw;
+    d->pitch = sim_pitch;
+    d->roll = sim_roll;
+}
+
+void imu_sim_reset(void)
+{
+    sim_yaw = 0.f;
+    sim_pitch = 0.f;
+    sim_roll = 0.f;
 }
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "imusampler.h"
+#include <stdio.h>
+#include <string.h>
+
+#define IMU_RING_MASK (IMU_RING_SIZE - 1)
+
+// Producer side: never blocks and never looks at the reader. A reader
+// that fell a whole ring behind only wants the newest sample anyway, so
+// the oldest slot is overwritten rather than the fresh sample dropped.
+static void ring_push(imu_sampler_t *s, const imu_sample_t *smp)
+{
+    unsigned head = (unsigned)SDL_AtomicGet(&s->head);
+    unsigned tail = (unsigned)SDL_AtomicGet(&s->tail);
+
+    if (head - tail >= IMU_RING_SIZE)
+    {
+        SDL_AtomicAdd(&s->dropped, 1);
+    }
+
+    s->ring[head & IMU_RING_MASK] = *smp;
+
+    // Publish the slot only after its contents are written
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&s->head, (int)(head + 1));
+}
+
+// Fusion step for one sample, then publish it
+static void publish(imu_sampler_t *s, imu_sample_t *smp, float dt)
+{
+    fusion_update(&s->fusion, &smp->raw, dt);
+
+    smp->q = s->fusion.q;
+    fusion_rate(&s->fusion, &smp->raw, &smp->wx, &smp->wy, &smp->wz);
+    orient_quat_to_euler(smp->q, &smp->angles.yaw, &smp->angles.pitch, &smp->angles.roll);
+    ring_push(s, smp);
+}
+
+// One direct register read; dt comes from the timestamps
+static void poll_direct(imu_sampler_t *s)
+{
+    imu_sample_t smp;
+    smp.t = SDL_GetPerformanceCounter();
+
+    if (imu_read_raw(&smp.raw) == 0)
+    {
+        float dt = s->last_t ? (float)((double)(smp.t - s->last_t) /
+                                       (double)SDL_GetPerformanceFrequency()) : 0.0f;
+        if (dt > 0.05f)
+        {
+            dt = 0.05f;     // don't integrate across a long stall
+        }
+
+        s->last_t = smp.t;
+        publish(s, &smp, dt);
+    }
+    else
+    {
+        SDL_AtomicAdd(&s->errors, 1);
+    }
+}
+
+// Everything queued in the FIFO; the newest packet is taken as "now".
+// Packets are evenly spaced, so fusion runs at a fixed step. After an
+// overflow the first packet is further from the last one than that:
+// the rotation in between is integrated at its rate rather than lost.
+static void poll_fifo(imu_sampler_t *s, Uint64 sample_period)
+{
+    const float dt = 1.0f / (float)s->cfg.sample_rate_hz;
+    imu_raw_t raw[IMU_FIFO_MAX_BATCH];
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    int n = imu_read_fifo(raw, IMU_FIFO_MAX_BATCH);
+    if (n == IMU_FIFO_OVERFLOW)
+    {
+        SDL_AtomicAdd(&s->overflows, 1);
+        s->resync = 1;
+        return;
+    }
+    if (n < 0)
+    {
+        SDL_AtomicAdd(&s->errors, 1);
+        return;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        imu_sample_t smp;
+        smp.t = now - (Uint64)(n - 1 - i) * sample_period;
+        smp.raw = raw[i];
+
+        if (s->resync && s->last_t && smp.t > s->last_t)
+        {
+            float gap = (float)((double)(smp.t - s->last_t) /
+                                (double)SDL_GetPerformanceFrequency()) - dt;
+            if (gap > IMU_MAX_GAP_S)
+            {
+                gap = IMU_MAX_GAP_S;
+            }
+            fusion_bridge(&s->fusion, &smp.raw, gap);
+        }
+        s->resync = 0;
+        s->last_t = smp.t;
+
+        publish(s, &smp, dt);
+    }
+}
+
+static int sampler_main(void *arg)
+{
+    imu_sampler_t *s = (imu_sampler_t*)arg;
+
+    const Uint64 freq = SDL_GetPerformanceFrequency();
+    const int poll_hz = s->cfg.use_fifo ? IMU_FIFO_POLL_HZ : s->cfg.sample_rate_hz;
+    const Uint64 period = freq / (Uint64)poll_hz;
+    const Uint64 sample_period = freq / (Uint64)s->cfg.sample_rate_hz;
+    Uint64 next = SDL_GetPerformanceCounter();
+
+    while (!SDL_AtomicGet(&s->quit))
+    {
+        if (s->cfg.use_fifo)
+        {
+            poll_fifo(s, sample_period);
+        }
+        else
+        {
+            poll_direct(s);
+        }
+
+        // Fixed-rate schedule; resync instead of bursting after a stall
+        next += period;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now >= next)
+        {
+            if (now - next > period)
+            {
+                next = now;
+            }
+            continue;
+        }
+
+        Uint32 wait_ms = (Uint32)((next - now) * 1000 / freq);
+        if (wait_ms > 0)
+        {
+            SDL_Delay(wait_ms);
+        }
+    }
+
+    return 0;
+}
+
+int imusampler_start(imu_sampler_t *s, const imu_config_t *cfg)
+{
+    if (!s || !cfg || cfg->sample_rate_hz <= 0)
+    {
+        return -1;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    fusion_init(&s->fusion, FUSION_KP, FUSION_KI);
+
+    s->thread = SDL_CreateThread(sampler_main, "imusampler", s);
+    if (!s->thread)
+    {
+        fprintf(stderr, "imusampler: SDL_CreateThread %s\n", SDL_GetError());
+        return -1;
+    }
+
+    return 0;
+}
+
+int imusampler_latest(imu_sampler_t *s, imu_sample_t *out)
+{
+    unsigned tail = (unsigned)SDL_AtomicGet(&s->tail);
+
+    for (;;)
+    {
+        unsigned head = (unsigned)SDL_AtomicGet(&s->head);
+        SDL_MemoryBarrierAcquire();
+
+        if (tail == head)
+        {
+            return -1;
+        }
+
+        *out = s->ring[(head - 1) & IMU_RING_MASK];
+
+        // The sampler rewrites slot head-1 once it has moved a whole
+        // ring on; if it got that far during the copy, take a newer one
+        SDL_MemoryBarrierAcquire();
+        unsigned now = (unsigned)SDL_AtomicGet(&s->head);
+        if (now - head < IMU_RING_SIZE - 1)
+        {
+            SDL_AtomicSet(&s->tail, (int)head);
+            return 0;
+        }
+    }
+}
+
+void imusampler_stop(imu_sampler_t *s)
+{
+    if (!s || !s->thread)
+    {
+        return;
+    }
+
+    SDL_AtomicSet(&s->quit, 1);
+    SDL_WaitThread(s->thread, NULL);
+    s->thread = NULL;
+}
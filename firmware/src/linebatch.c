@@ -0,0 +1,182 @@
+#include "linebatch.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int reserve(line_batch_t *b, size_t more_verts, size_t more_indices)
+{
+    if (b->n_verts + more_verts > b->vert_cap)
+    {
+        size_t cap = b->vert_cap ? b->vert_cap : 1024;
+        while (cap < b->n_verts + more_verts)
+        {
+            cap *= 2;
+        }
+
+        SDL_Vertex *v = (SDL_Vertex*)realloc(b->verts, sizeof(SDL_Vertex) * cap);
+        if (!v)
+        {
+            return -1;
+        }
+        b->verts = v;
+        b->vert_cap = cap;
+    }
+
+    if (b->n_indices + more_indices > b->index_cap)
+    {
+        size_t cap = b->index_cap ? b->index_cap : 3072;
+        while (cap < b->n_indices + more_indices)
+        {
+            cap *= 2;
+        }
+
+        int *idx = (int*)realloc(b->indices, sizeof(int) * cap);
+        if (!idx)
+        {
+            return -1;
+        }
+        b->indices = idx;
+        b->index_cap = cap;
+    }
+
+    return 0;
+}
+
+int linebatch_init(line_batch_t *b, float width)
+{
+    if (!b)
+    {
+        return -1;
+    }
+
+    memset(b, 0, sizeof(*b));
+    b->width = width;
+    return reserve(b, 1024, 3072);
+}
+
+void linebatch_begin(line_batch_t *b)
+{
+    b->n_verts = 0;
+    b->n_indices = 0;
+}
+
+// Two vertices either side of (x, y) along normal (nx, ny)
+static void put_pair(SDL_Vertex *v, float x, float y, float nx, float ny, SDL_Color color)
+{
+    v[0].position.x = x + nx;
+    v[0].position.y = y + ny;
+    v[1].position.x = x - nx;
+    v[1].position.y = y - ny;
+
+    for (int k = 0; k < 2; k++)
+    {
+        v[k].color = color;
+        v[k].tex_coord.x = 0.0f;
+        v[k].tex_coord.y = 0.0f;
+    }
+}
+
+// Quads between consecutive vertex pairs starting at base: (0 1 2) (1 3 2)
+static void put_quads(line_batch_t *b, int base, int n_quads)
+{
+    int *idx = &b->indices[b->n_indices];
+    for (int i = 0; i < n_quads; i++)
+    {
+        int q = base + 2*i;
+        idx[0] = q;
+        idx[1] = q + 1;
+        idx[2] = q + 2;
+        idx[3] = q + 1;
+        idx[4] = q + 3;
+        idx[5] = q + 2;
+        idx += 6;
+    }
+    b->n_indices += 6 * (size_t)n_quads;
+}
+
+int linebatch_segment(line_batch_t *b, float x0, float y0, float x1, float y1,
+                      SDL_Color color)
+{
+    if (reserve(b, 4, 6) != 0)
+    {
+        return -1;
+    }
+
+    float tx = x1 - x0, ty = y1 - y0;
+    float len = sqrtf(tx*tx + ty*ty);
+    float hw = 0.5f * b->width;
+    float nx = 0.0f, ny = hw;
+    if (len > 1e-6f)
+    {
+        nx = -ty * hw / len;
+        ny = tx * hw / len;
+    }
+
+    int base = (int)b->n_verts;
+    put_pair(&b->verts[base], x0, y0, nx, ny, color);
+    put_pair(&b->verts[base + 2], x1, y1, nx, ny, color);
+    b->n_verts += 4;
+
+    put_quads(b, base, 1);
+    return 0;
+}
+
+int linebatch_strip(line_batch_t *b, const float *xy, int n, SDL_Color color)
+{
+    if (n < 2)
+    {
+        return 0;
+    }
+    if (reserve(b, 2 * (size_t)n, 6 * (size_t)(n - 1)) != 0)
+    {
+        return -1;
+    }
+
+    float hw = 0.5f * b->width;
+    float nx = 0.0f, ny = hw;
+    int base = (int)b->n_verts;
+
+    for (int i = 0; i < n; i++)
+    {
+        // Normal from the neighbours, so joints between segments close up
+        int p = (i > 0) ? i - 1 : i;
+        int q = (i + 1 < n) ? i + 1 : i;
+        float tx = xy[2*q] - xy[2*p];
+        float ty = xy[2*q + 1] - xy[2*p + 1];
+        float len = sqrtf(tx*tx + ty*ty);
+        if (len > 1e-6f)
+        {
+            nx = -ty * hw / len;
+            ny = tx * hw / len;
+        }
+
+        put_pair(&b->verts[base + 2*i], xy[2*i], xy[2*i + 1], nx, ny, color);
+    }
+    b->n_verts += 2 * (size_t)n;
+
+    put_quads(b, base, n - 1);
+    return 0;
+}
+
+int linebatch_flush(line_batch_t *b, SDL_Renderer *ren)
+{
+    if (b->n_indices == 0)
+    {
+        return 0;
+    }
+
+    return SDL_RenderGeometry(ren, NULL, b->verts, (int)b->n_verts,
+                              b->indices, (int)b->n_indices);
+}
+
+void linebatch_free(line_batch_t *b)
+{
+    if (!b)
+    {
+        return;
+    }
+
+    free(b->verts);
+    free(b->indices);
+    memset(b, 0, sizeof(*b));
+}
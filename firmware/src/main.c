@@ -5,78 +5,42 @@
 #include <time.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include "imu.h"
+#include "imusampler.h"
+#include "fusion.h"
 #include "stars.h"
 #include "astro.h"
-
-static void renderText(SDL_Renderer* ren, TTF_Font* font, const char* msg, int x, int y);
-static void draw_horizon(SDL_Renderer *ren,
-                         float rx, float ry, float rz,
-                         float ux, float uy, float uz,
-                         float fx, float fy, float fz,
-                         int W, int H, float FOV);
-static void draw_cardinals(SDL_Renderer *ren, TTF_Font *font,
-                           float rx, float ry, float rz,
-                           float ux, float uy, float uz,
-                           float fx, float fy, float fz,
-                           int W, int H, float FOV);
-static int project_altaz(float alt_deg, float az_deg,
-                         float rx, float ry, float rz,
-                         float ux, float uy, float uz,
-                         float fx, float fy, float fz,
-                         int W, int H, float FOV,
+#include "skyindex.h"
+#include "starcache.h"
+#include "skyview.h"
+#include "skycube.h"
+#include "grid.h"
+#include "constellations.h"
+#include "atmos.h"
+#include "solsys.h"
+#include "simclock.h"
+#include "textcache.h"
+#include "orient.h"
+#include "prof.h"
+#include "pacer.h"
+
+static void renderText(text_cache_t* tc, TTF_Font* font, const char* msg, int x, int y);
+static void draw_cardinals(text_cache_t *tc, TTF_Font *font, const camera_t *cam);
+static void draw_bodies(const solsys_t *ss, double jd, const camera_t *cam_eq,
+                        float zx, float zy, float zz, const atmos_t *atm, float mag_cutoff,
+                        star_batch_t *batch, SDL_Renderer *ren,
+                        text_cache_t *tc, TTF_Font *font);
+static int project_altaz(float alt_deg, float az_deg, const camera_t *cam,
                          int *outx, int *outy)
 {
 	float x, y, z;
 	astro_altaz_to_unit(alt_deg, az_deg, &x, &y, &z);
 
-	return astro_project_dir(x, y, z,
-                            rx, ry, rz,
-                            ux, uy, uz,
-                            fx, fy, fz,
-                            W, H, FOV,
-                            outx, outy, NULL);
-}
-
-static void draw_horizon(SDL_Renderer *ren,
-                         float rx, float ry, float rz,
-                         float ux, float uy, float uz,
-                         float fx, float fy, float fz,
-                         int W, int H, float FOV)
-{
-	  // Draw horizon as a polyline by sampling azimuth around 0..360
-    const float ALT = 0.0f;     // horizon
-    const float STEP = 2.0f;    // degrees per segment (smoothness vs cost)
-
-    int prev_ok = 0;
-    int px0 = 0, py0 = 0;
-
-    for (float az = 0.0f; az <= 360.0f; az += STEP)
-    {
-        int px, py;
-        int ok = project_altaz(ALT, az,
-                               rx, ry, rz,
-                               ux, uy, uz,
-                               fx, fy, fz,
-                               W, H, FOV,
-                               &px, &py);
-
-        if (ok && prev_ok)
-        {
-            SDL_RenderDrawLine(ren, px0, py0, px, py);
-        }
-
-        prev_ok = ok;
-        px0 = px;
-        py0 = py;
-    }
+	return astro_camera_project(cam, x, y, z, outx, outy, NULL);
 }
 
-static void draw_cardinals(SDL_Renderer *ren, TTF_Font *font,
-                           float rx, float ry, float rz,
-                           float ux, float uy, float uz,
-                           float fx, float fy, float fz,
-                           int W, int H, float FOV)
+static void draw_cardinals(text_cache_t *tc, TTF_Font *font, const camera_t *cam)
 {
     // Slightly above horizon so labels are visible
     const float ALT_LABEL = 5.0f;
@@ -91,82 +55,22 @@ static void draw_cardinals(SDL_Renderer *ren, TTF_Font *font,
     for (size_t i = 0; i < sizeof(marks)/sizeof(marks[0]); i++)
     {
         int x, y;
-        if (project_altaz(ALT_LABEL, marks[i].az,
-                          rx, ry, rz,
-                          ux, uy, uz,
-                          fx, fy, fz,
-                          W, H, FOV,
-                          &x, &y))
+        if (project_altaz(ALT_LABEL, marks[i].az, cam, &x, &y))
         {
-            renderText(ren, font, marks[i].txt, x - 8, y - 8);
+            renderText(tc, font, marks[i].txt, x - 8, y - 8);
         }
     }
 
     // Optional: Zenith marker ("UP") at alt=90 (always useful)
     {
         int x, y;
-        if (project_altaz(90.0f, 0.0f,
-                          rx, ry, rz,
-                          ux, uy, uz,
-                          fx, fy, fz,
-                          W, H, FOV,
-                          &x, &y))
+        if (project_altaz(90.0f, 0.0f, cam, &x, &y))
         {
-            renderText(ren, font, "UP", x - 16, y - 12);
+            renderText(tc, font, "UP", x - 16, y - 12);
         }
     }
 }
 
-static float wrap_deg_360(float a)
-{
-	while (a < 0.0f)
-	{
-		a += 360.0f;
-	}
-	while (a >= 360.0f)
-	{
-		a -= 360.0f;
-	}
-	return a;
-}
-
-// Returns the signed smallest difference a-b in degrees, range (-180, +180)
-static float angle_diff_deg(float a, float b)
-{
-	float d = a - b;
-	while (d > 180.0f)
-	{
-		d -= 360.0f;
-	}
-	while (d < -180.0f)
-	{
-		d += 360.0f;
-	}
-	return d;
-}
-
-
-// Exponential smoothing that is dt-correct (time-constant based)
-static float smooth_exp(float current, float target, float dt, float tau)
-{
-	// tau: smaller = snappy, larger = smoother
-	if (tau <= 0.0001f)
-	{
-		return target;
-	}
-
-	float alpha = 1.0f - expf(-dt / tau);
-	return current + alpha * (target-current);
-}
-
-// Wrap-safe yaw smoothing
-static float smooth_yaw(float yaw_smooth, float yaw_raw, float dt, float tau)
-{
-	float d = angle_diff_deg(yaw_raw, yaw_smooth);
-	float yaw_target = yaw_smooth + d;
-	return wrap_deg_360(smooth_exp(yaw_smooth, yaw_target, dt, tau));
-}
-
 static double get_jd_utc_now(void)
 {
 	time_t t = time(NULL);
@@ -180,50 +84,86 @@ static double get_jd_utc_now(void)
 								g.tm_hour, g.tm_min, (double)g.tm_sec);
 }
 
-static int mag_to_radius(float mag)
+/*
+ * Sun, Moon and planets from the cached ephemeris. They take the same
+ * path as the stars: equatorial unit vector, horizon test (refracted
+ * when the atmosphere is on), equatorial camera, one sprite batch.
+ */
+static void draw_bodies(const solsys_t *ss, double jd, const camera_t *cam_eq,
+                        float zx, float zy, float zz, const atmos_t *atm, float mag_cutoff,
+                        star_batch_t *batch, SDL_Renderer *ren,
+                        text_cache_t *tc, TTF_Font *font)
 {
-	if (mag <= 1.0f)	// very bright
-	{
-		return 3;
-	}
+    // Typical magnitude decides whether the cut hides a body
+    static const struct { SDL_Color color; int radius; float mag; } style[SOLSYS_BODY_COUNT] = {
+        {{255, 230, 120, 255}, 3, -26.7f},  // Sun
+        {{230, 230, 210, 255}, 3, -12.7f},  // Moon
+        {{200, 190, 170, 255}, 1,   0.0f},  // Mercury
+        {{255, 250, 220, 255}, 2,  -4.2f},  // Venus
+        {{255, 140,  90, 255}, 1,   0.7f},  // Mars
+        {{250, 230, 200, 255}, 2,  -2.2f},  // Jupiter
+        {{240, 220, 160, 255}, 1,   0.6f},  // Saturn
+        {{170, 220, 230, 255}, 0,   5.7f},  // Uranus
+        {{130, 160, 255, 255}, 0,   7.8f},  // Neptune
+    };
 
-	if (mag <= 2.5f)	// bright
-	{
-		return 2;
-	}
+    int px[SOLSYS_BODY_COUNT], py[SOLSYS_BODY_COUNT];
+    int shown[SOLSYS_BODY_COUNT];
 
-	if (mag <= 4.0f)	// medium
-	{
-		return 1;
-	}
+    starbatch_begin(batch);
+    for (int b = 0; b < SOLSYS_BODY_COUNT; b++)
+    {
+        shown[b] = 0;
+        if (style[b].mag > mag_cutoff)
+        {
+            continue;
+        }
+
+        float x, y, z;
+        solsys_direction(ss, (solsys_body_t)b, jd, zx, zy, zz, &x, &y, &z);
+
+        float h = x*zx + y*zy + z*zz;
+        if (h < (atm ? atm->h_visible : 0.0f))
+        {
+            continue;
+        }
+        if (atm)
+        {
+            float wa, wb, dmag;
+            atmos_lookup(atm, h, &wa, &wb, &dmag);
+            x = wa*x + wb*zx;
+            y = wa*y + wb*zy;
+            z = wa*z + wb*zz;
+        }
 
-	return 0;			// faint
+        if (astro_camera_project(cam_eq, x, y, z, &px[b], &py[b], NULL))
+        {
+            starbatch_add(batch, px[b], py[b], style[b].radius, style[b].color);
+            shown[b] = 1;
+        }
+    }
+    starbatch_flush(batch, ren);
+
+    for (int b = 0; b < SOLSYS_BODY_COUNT; b++)
+    {
+        if (shown[b])
+        {
+            renderText(tc, font, solsys_name((solsys_body_t)b), px[b] + 6, py[b] - 6);
+        }
+    }
 }
 
 /*
  * Helper Function to render ASCII text to SDL renderer using SDL_tff.
- * Converts a string to a surface, then to a texture, and finally
- * copies it to the renderer at specified screen position.
+ * Goes through the text cache, so a label is rasterized and uploaded
+ * once and later frames only copy the cached texture.
  * 
  * Also kept separate from main render loop to avoid clutter.
  */
-static void renderText(SDL_Renderer* ren, TTF_Font* font, const char* msg, int x, int y)
+static void renderText(text_cache_t* tc, TTF_Font* font, const char* msg, int x, int y)
 {
 	SDL_Color white = {255,255,255,255};
-
-	// Renders text into intermediate surface.
-	SDL_Surface* surf = TTF_RenderText_Solid(font, msg, white);
-	if (!surf) return;
-
-	// Converts surface to GPU texture.
-	SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-	if (tex)
-	{
-		SDL_Rect dst = {x, y, surf->w, surf->h};
-		SDL_RenderCopy(ren, tex, NULL, &dst);
-		SDL_DestroyTexture(tex);
-	}
-	SDL_FreeSurface(surf);
+	textcache_draw(tc, font, msg, white, x, y);
 }
 
 /*
@@ -253,6 +193,32 @@ static TTF_Font* open_font(int ptsize)
 	return NULL;
 }
 
+/*
+ * Resolves an asset file name. The build copies assets (and the
+ * generated stars.bin) next to the executable, so that directory is
+ * tried first; running from the repository root without installing
+ * falls back to the source tree.
+ */
+static const char* asset_path(char* out, size_t n, const char* name)
+{
+	char* base = SDL_GetBasePath();
+	if (base)
+	{
+		snprintf(out, n, "%sassets/%s", base, name);
+		SDL_free(base);
+
+		FILE* f = fopen(out, "rb");
+		if (f)
+		{
+			fclose(f);
+			return out;
+		}
+	}
+
+	snprintf(out, n, "firmware/assets/%s", name);
+	return out;
+}
+
 int main(void)
 {
 	// Initialize SDL video subsystem.
@@ -286,7 +252,8 @@ int main(void)
 	}
 
 	// Creates a hardware-accelerated renderer for drawing.
-	SDL_Renderer* ren = SDL_CreateRenderer(w, -1, SDL_RENDERER_ACCELERATED);
+	// Presents are synced to the display so frames never tear or outrun it.
+	SDL_Renderer* ren = SDL_CreateRenderer(w, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
 	if (!ren)
 	{
 		fprintf(stderr, "SDL_CreateRenderer: %s\n", SDL_GetError());
@@ -309,11 +276,13 @@ int main(void)
 		return 1;
 	}
 
-	// Load star catalog
+	// Load star catalog (prefer the mapped binary, fall back to CSV)
+	char path[1024];
 	star_catalog_t catalog;
-	if (stars_load_csv(&catalog, "firmware/assets/stars.csv") != 0)
+	if (stars_load_bin(&catalog, asset_path(path, sizeof(path), "stars.bin")) != 0 &&
+		stars_load_csv(&catalog, asset_path(path, sizeof(path), "stars.csv")) != 0)
 	{
-		fprintf(stderr, "Failed to load stars CSV\n");
+		fprintf(stderr, "Failed to load star catalog\n");
 		TTF_CloseFont(font);
 		SDL_DestroyRenderer(ren);
 		SDL_DestroyWindow(w);
@@ -323,23 +292,75 @@ int main(void)
 	}
 
 	printf("Loaded %zu stars\n", catalog.count);
+	printf("Projection kernel: %s\n", astro_batch_impl());
 
-	float *cache_lx = (float*)malloc(sizeof(float) * catalog.count);
-	float *cache_ly = (float*)malloc(sizeof(float) * catalog.count);
-	float *cache_lz = (float*)malloc(sizeof(float) * catalog.count);
-	unsigned char *cache_vis = (unsigned char*)malloc(sizeof(unsigned char) * catalog.count);
-	unsigned char *cache_rad = (unsigned char*)malloc(sizeof(unsigned char) * catalog.count);
+	text_cache_t text_cache;
+	if (textcache_init(&text_cache, ren, 64) != 0)
+	{
+		fprintf(stderr, "Failed to create text cache\n");
+
+		stars_free(&catalog);
+		TTF_CloseFont(font);
+		SDL_DestroyRenderer(ren);
+		SDL_DestroyWindow(w);
+		TTF_Quit();
+		SDL_Quit();
+		return 1;
+	}
+
+	// Star layer scratch (candidate arrays, tile list, sprite batch)
+	sky_view_t sky_view;
+	if (skyview_init(&sky_view, ren, catalog.count) != 0)
+	{
+		fprintf(stderr, "Failed to create star layer\n");
+
+		textcache_free(&text_cache);
+		stars_free(&catalog);
+		TTF_CloseFont(font);
+		SDL_DestroyRenderer(ren);
+		SDL_DestroyWindow(w);
+		TTF_Quit();
+		SDL_Quit();
+		return 1;
+	}
 
-	if (!cache_lx || !cache_ly || !cache_lz || !cache_vis || !cache_rad)
+	// Horizon and coordinate grid lines ('G' cycles the grids)
+	sky_grid_t sky_grid;
+	if (grid_init(&sky_grid) != 0)
 	{
-		fprintf(stderr, "Failed to allocate star cache arrays\n");
+		fprintf(stderr, "Failed to create sky grid\n");
 
-		free(cache_lx);
-		free(cache_ly);
-		free(cache_lz);
-		free(cache_vis);
-		free(cache_rad);
+		skyview_free(&sky_view);
+		textcache_free(&text_cache);
+		stars_free(&catalog);
+		TTF_CloseFont(font);
+		SDL_DestroyRenderer(ren);
+		SDL_DestroyWindow(w);
+		TTF_Quit();
+		SDL_Quit();
+		return 1;
+	}
+	int grid_mode = 0;	// bit 0: alt/az, bit 1: RA/Dec
+
+	// Sky time is seeded from the wall clock once and then advances
+	// with the frame clock (sub-second) at the simulated rate:
+	// '-' / '=' step x1 .. x10000 either way, Space stops, Backspace
+	// returns to now.
+	sim_clock_t sim_clock;
+	simclock_init(&sim_clock, get_jd_utc_now(), SDL_GetTicks());
+
+	// Equatorial unit vectors, radii and the sky index are built on a
+	// worker thread; the first frames draw without stars until it is ready.
+	// Positions are propagated to today's date there, once; sidereal
+	// rotation lives in the per-frame view basis instead.
+	star_cache_t star_cache;
+	if (starcache_start(&star_cache, &catalog, simclock_jd(&sim_clock, SDL_GetTicks())) != 0)
+	{
+		fprintf(stderr, "Failed to start star cache\n");
 
+		grid_free(&sky_grid);
+		skyview_free(&sky_view);
+		textcache_free(&text_cache);
 		stars_free(&catalog);
 		TTF_CloseFont(font);
 		SDL_DestroyRenderer(ren);
@@ -349,32 +370,134 @@ int main(void)
 		return 1;
 	}
 
-	static int smooth_init = 0;
-	static float yaw_s = 0.0f;
-	static float pitch_s = 0.0f;
-	static float roll_s = 0.0f;
+	// Constellation figures ('K'). Optional: without the asset the sky
+	// is drawn as before.
+	constellations_t constellations;
+	int const_ok = (constellations_load(&constellations, &catalog,
+										asset_path(path, sizeof(path), "constellations.csv")) == 0);
+	int show_const = const_ok;
+	if (const_ok)
+	{
+		printf("Loaded %zu constellations (%zu segments, %zu unresolved)\n",
+			   constellations.n_figures, constellations.n_seg, constellations.n_missing);
+	}
+
+	// Optional cube-map cache of the star field ('C'). Without render
+	// target support the app just keeps drawing stars directly.
+	sky_cube_t sky_cube;
+	int cube_ok = (skycube_init(&sky_cube, ren, 0, SKYCUBE_REFRESH_MS) == 0);
+	int use_cube = 0;
+	printf("Sky cube: %s\n", cube_ok ? "available" : "unavailable");
+
+	// Per-stage frame timers. Set POCKET_TRACE to a .json (Chrome trace)
+	// or .csv path to also record every frame to a file.
+	profiler_t prof;
+	prof_init(&prof);
+
+	const char *trace_path = getenv("POCKET_TRACE");
+	if (trace_path && prof_open_trace(&prof, trace_path) == 0)
+	{
+		printf("Writing frame trace to %s\n", trace_path);
+	}
 
-	static float yaw_off = 0.0f;
-	static float pitch_off = 0.0f;
-	static float roll_off = 0.0f;
+	// Press 'P' to show the per-stage breakdown (refreshed with the FPS)
+	int show_prof = 0;
+	prof_stats_t prof_view[PROF_STAGE_COUNT];
+	memset(prof_view, 0, sizeof(prof_view));
+	float rebuild_ms = 0.0f;
 
+	// Heading reference. There is no magnetometer, so after a 2 s
+	// settle the current view direction is taken as North. Tilt needs
+	// no offset: the fused attitude is already gravity-referenced.
 	static int cal_done = 0;
-	static float cal_sum_yaw = 0.0f;
-	static float cal_sum_pitch = 0.0f;
-	static float cal_sum_roll = 0.0f;
-	static int cal_count = 0;
 	static Uint32 cal_start_ms = 0;
+	static quat_t heading_off = {1.0f, 0.0f, 0.0f, 0.0f};
 
+	// Limiting magnitude. The catalog is sorted brightest first, so the
+	// stars that pass are always the prefix [0, n_bright).
 	float mag_cutoff = 5.5f;
+	size_t n_bright = stars_mag_prefix(&catalog, mag_cutoff);
+
+	// Refraction and extinction tables ('A' toggles). There is no
+	// weather sensor; POCKET_TEMP_C and POCKET_PRESSURE_HPA override
+	// the standard conditions.
+	static atmos_t atmos;
+	const char *temp_env = getenv("POCKET_TEMP_C");
+	const char *pres_env = getenv("POCKET_PRESSURE_HPA");
+	float temp_c = temp_env ? (float)atof(temp_env) : ATMOS_DEFAULT_TEMP_C;
+	float pressure_hpa = pres_env ? (float)atof(pres_env) : ATMOS_DEFAULT_PRESSURE_HPA;
+	int use_atmos = (atmos_init(&atmos, temp_c, pressure_hpa) == 0 ||
+					 atmos_init(&atmos, ATMOS_DEFAULT_TEMP_C, ATMOS_DEFAULT_PRESSURE_HPA) == 0);
+	int atmos_ok = use_atmos;
+	if (atmos_ok)
+	{
+		printf("Atmosphere: %.1f C, %.0f hPa\n", atmos.temp_c, atmos.pressure_hpa);
+	}
+
+	// Sun, Moon and planets ('B' toggles); fit on the first frame
+	static solsys_t solsys;
+	solsys_init(&solsys);
+	int show_bodies = 1;
+
 	// Tries to initialize the IMU once.
 	// If it fails, fall back to SIM mode automatically.
 	int imu_ok = (imu_init() == 0);
 
+	// Default rate through the on-chip FIFO; without it, one read per sample
+	imu_config_t imu_cfg;
+	imu_default_config(&imu_cfg);
+	if (imu_ok && imu_configure(&imu_cfg) != 0)
+	{
+		fprintf(stderr, "IMU FIFO setup failed, using direct reads\n");
+		imu_cfg.use_fifo = 0;
+	}
+
+	// The sensor is polled on its own thread so bus reads never land
+	// in the frame; the loop only picks up the newest sample.
+	imu_sampler_t imu_sampler;
+	if (imu_ok && imusampler_start(&imu_sampler, &imu_cfg) != 0)
+	{
+		imu_close();
+		imu_ok = 0;
+	}
+
+	// Latest fused sample from the sampler (zeroed until the first one)
+	imu_sample_t imu_smp;
+	memset(&imu_smp, 0, sizeof(imu_smp));
+	int imu_have = 0;
+	Uint32 imu_last_ms = 0;
+
+	// Frame pacing: TARGET_FPS while moving, IDLE_FPS once the device
+	// has been still for a second. Vsync does the waiting when the
+	// driver honours it.
+	const int TARGET_FPS = 60;
+	const int IDLE_FPS = 5;
+
+	int vsync_hz = 0;
+	SDL_RendererInfo ren_info;
+	if (SDL_GetRendererInfo(ren, &ren_info) == 0 && (ren_info.flags & SDL_RENDERER_PRESENTVSYNC))
+	{
+		SDL_DisplayMode mode;
+		vsync_hz = (SDL_GetWindowDisplayMode(w, &mode) == 0 && mode.refresh_rate > 0) ? mode.refresh_rate : 60;
+	}
+	printf("Vsync: %s\n", vsync_hz ? "on" : "off");
+
+	frame_pacer_t pacer;
+	pacer_init(&pacer, TARGET_FPS, IDLE_FPS, vsync_hz);
+
 	// Press 'S' to force SIM mode even if IMU works (for demo/testing)).
 	int force_sim = 0;
 
-	// Orientation values come from IMU when available.
-	float yaw = 0.f, pitch = 0.f, roll = 0.f;
+	// Motion-to-photon: IMU sample time -> SDL_RenderPresent returning.
+	// The camera is extrapolated along the gyro rate to when the frame
+	// is expected on screen: sample age + render time (running average)
+	// + a lead that 'L' toggles and ',' / '.' tune in 2 ms steps.
+	const double ticks_per_ms = (double)SDL_GetPerformanceFrequency() / 1000.0;
+	int predict_on = 1;
+	float predict_lead_ms = 0.0f;
+	float predict_ms = 0.0f;
+	float render_ms_avg = 0.0f;
+	float m2p_ms = 0.0f;
 
 	// Timing reference for frame delta calculation.
 	Uint32 last = SDL_GetTicks();
@@ -395,11 +518,22 @@ int main(void)
 	const double LAT_DEG = 32.7357;
 	const double LON_DEG = -97.1081;
 
+	// Screen constants (focal length, center, cone) are fixed; only the
+	// orientation changes per frame.
+	camera_t cam;
+	astro_camera_init(&cam, W, H, FOV);
+	camera_t cam_eq = cam;
+
 	while (running)	// Main application loop
 	{
+		prof_frame_begin(&prof);
+
 		// Handles user input and window events.
+		int input = 0;
 		while (SDL_PollEvent(&e))
 		{
+			input = 1;
+
 			if (e.type == SDL_QUIT) // window close
 			{
 				running = 0; 
@@ -415,6 +549,86 @@ int main(void)
 			{
 				force_sim = !force_sim;
 			}
+
+			// Cycle grids with 'G': none, alt/az, RA/Dec, both
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_g)
+			{
+				grid_mode = (grid_mode + 1) & 3;
+			}
+
+			// Toggle constellation figures with 'K'
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_k && const_ok)
+			{
+				show_const = !show_const;
+			}
+
+			// Toggle refraction and extinction with 'A'
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_a && atmos_ok)
+			{
+				use_atmos = !use_atmos;
+			}
+
+			// Toggle the Sun, Moon and planets with 'B'
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_b)
+			{
+				show_bodies = !show_bodies;
+			}
+
+			// Time warp: '-' / '=' step the rate, Space stops, Backspace resets
+			if (e.type == SDL_KEYDOWN &&
+				(e.key.keysym.sym == SDLK_MINUS || e.key.keysym.sym == SDLK_EQUALS))
+			{
+				simclock_step(&sim_clock, (e.key.keysym.sym == SDLK_EQUALS) ? 1 : -1, SDL_GetTicks());
+			}
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_SPACE)
+			{
+				simclock_toggle_pause(&sim_clock, SDL_GetTicks());
+			}
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_BACKSPACE)
+			{
+				simclock_reset(&sim_clock, get_jd_utc_now(), SDL_GetTicks());
+			}
+
+			// Toggle the cube-map star cache with 'C'
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_c && cube_ok)
+			{
+				use_cube = !use_cube;
+			}
+
+			// Render targets lose their contents on some drivers
+			if ((e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) && cube_ok)
+			{
+				skycube_invalidate(&sky_cube);
+			}
+
+			// Toggle the profiler overlay with 'P'
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_p)
+			{
+				show_prof = !show_prof;
+			}
+
+			// Toggle orientation prediction with 'L', tune its lead with ',' / '.'
+			if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_l)
+			{
+				predict_on = !predict_on;
+			}
+			if (e.type == SDL_KEYDOWN &&
+				(e.key.keysym.sym == SDLK_COMMA || e.key.keysym.sym == SDLK_PERIOD))
+			{
+				predict_lead_ms += (e.key.keysym.sym == SDLK_PERIOD) ? 2.0f : -2.0f;
+				if (predict_lead_ms < -20.0f) predict_lead_ms = -20.0f;
+				if (predict_lead_ms > 40.0f) predict_lead_ms = 40.0f;
+			}
+
+			// '[' / ']' lower/raise the limiting magnitude
+			if (e.type == SDL_KEYDOWN &&
+				(e.key.keysym.sym == SDLK_LEFTBRACKET || e.key.keysym.sym == SDLK_RIGHTBRACKET))
+			{
+				mag_cutoff += (e.key.keysym.sym == SDLK_RIGHTBRACKET) ? 0.5f : -0.5f;
+				if (mag_cutoff < -1.0f) mag_cutoff = -1.0f;
+				if (mag_cutoff > 12.0f) mag_cutoff = 12.0f;
+				n_bright = stars_mag_prefix(&catalog, mag_cutoff);
+			}
 		}
 
 		// Calculate frame delta time (seconds).
@@ -422,117 +636,107 @@ int main(void)
 		float dt = (now - last) / 1000.0f;
 		last = now;
 
-		// Attempt to read from IMU.
-		if (!force_sim && imu_ok && imu_read(&imu) == 0)
+		// Pick up the newest IMU sample (never blocks).
+		// Timed by hand until the pacer knows whether this is a frame.
+		Uint64 t_imu = SDL_GetPerformanceCounter();
+		if (imu_ok && imusampler_latest(&imu_sampler, &imu_smp) == 0)
+		{
+			imu_last_ms = now;
+			imu_have = 1;
+		}
+
+		// Orientation comes from the IMU when available.
+		// Falls back to SIM if the sampler stops delivering (bus errors).
+		quat_t q;
+		Uint64 sample_t;
+		int live = (!force_sim && imu_have && now - imu_last_ms < 250);
+		if (live)
 		{
-			yaw = imu.yaw;
-			pitch = imu.pitch;
-			roll = imu.roll;
+			q = imu_smp.q;
+			sample_t = imu_smp.t;
 		}
 		else
 		{
 			// SIM fallback
 			imu_sim_step(&imu, dt);
-			yaw = imu.yaw;
-			pitch = imu.pitch;
-			roll = imu.roll;
+			q = orient_quat_from_euler(imu.yaw, imu.pitch, imu.roll);
+			sample_t = SDL_GetPerformanceCounter();
 		}
+		Uint64 t_orient = SDL_GetPerformanceCounter();
 
 		if (!cal_done)
 		{
 			if (cal_start_ms == 0)
 			{
 				cal_start_ms = now;
-				cal_sum_yaw = 0.0f;
-    			cal_sum_pitch = 0.0f;
-    			cal_sum_roll = 0.0f;
-    			cal_count = 0;
 			}
 
-			cal_sum_yaw += wrap_deg_360(yaw);
-			cal_sum_pitch += pitch;
-			cal_sum_roll += roll;
-			cal_count++;
-
-			if (now - cal_start_ms >= 2000 && cal_count > 0)
+			if (now - cal_start_ms >= 2000)
 			{
-				float avg_yaw = cal_sum_yaw / (float)cal_count;
-				float avg_pitch = cal_sum_pitch / (float)cal_count;
-				float avg_roll= cal_sum_roll / (float)cal_count;
-
-				yaw_off = avg_yaw;
-				pitch_off = avg_pitch;
-				roll_off = avg_roll;
-
+				heading_off = orient_quat_axis_angle(0.0f, 0.0f, 1.0f, -orient_quat_heading(q));
 				cal_done = 1;
-
-				smooth_init = 0;
 			}
 		}
 
-		yaw = wrap_deg_360(yaw - yaw_off);
-		pitch = pitch - pitch_off;
-		roll = roll - roll_off;
-
-		if (!smooth_init)
+		// Idle: nothing to draw until the next low-rate frame is due
+		int busy = input || !cal_done || starcache_busy(&star_cache) ||
+			(use_cube && sky_cube.dirty) || simclock_fast(&sim_clock);
+		pacer_update(&pacer, q, busy, now);
+		if (!pacer_frame_due(&pacer))
 		{
-			yaw_s = wrap_deg_360(yaw);
-			pitch_s = pitch;
-			roll_s = roll;
-			smooth_init = 1;
+			pacer_idle_wait(&pacer);
+			continue;
 		}
 
-		const float TAU_YAW = 0.10f;
-		const float TAU_PITCH = 0.08f;
-		const float TAU_ROLL = 0.08f;
+		// A frame is due: record the stages that ran before the pacer,
+		// so idle polls never show up in the statistics or the trace.
+		prof_add(&prof, PROF_IMU, t_imu, t_orient);
+		prof_add(&prof, PROF_ORIENT, t_orient, SDL_GetPerformanceCounter());
+		prof_begin(&prof, PROF_ORIENT);
 
-		yaw_s = smooth_yaw(yaw_s, yaw, dt, TAU_YAW);
-		pitch_s = smooth_exp(pitch_s, pitch, dt, TAU_PITCH);
-		roll_s = smooth_exp(roll_s, roll, dt, TAU_ROLL);
+		// Extrapolate to the expected display time
+		Uint64 t_camera = SDL_GetPerformanceCounter();
+		predict_ms = 0.0f;
+		if (live && predict_on)
+		{
+			float age_ms = (float)((double)(t_camera - sample_t) / ticks_per_ms);
+			predict_ms = age_ms + render_ms_avg + predict_lead_ms;
+			q = fusion_predict(q, imu_smp.wx, imu_smp.wy, imu_smp.wz, predict_ms / 1000.0f);
+		}
 
-		float rx, ry, rz, ux, uy, uz, fx, fy, fz;
-		astro_camera_basis(yaw_s, pitch_s, roll_s,
-						&rx, &ry, &rz,
-						&ux, &uy, &uz,
-						&fx, &fy, &fz);
+		// The fused attitude feeds the camera as-is: it is already
+		// filtered at sensor rate, so no smoothing lag on top.
+		q = orient_quat_mul(heading_off, q);
 
-		static Uint32 lastCacheMs = 0;
-		static double jd = 0;
+		float yaw, pitch, roll;
+		orient_quat_to_euler(q, &yaw, &pitch, &roll);
+		prof_end(&prof, PROF_ORIENT);
 
-		if (jd == 0 || now - lastCacheMs > 1000)
-		{
-			jd = get_jd_utc_now();
-			lastCacheMs = now;
+		prof_begin(&prof, PROF_CAMERA);
+		astro_camera_set_quat(&cam, q);
 
-			// TODO: replace with GPS later
-			for (size_t i = 0; i < catalog.count; i++)
-			{
-				float mag = catalog.items[i].mag;
+		// The equatorial -> local rotation is folded into the camera, so
+		// stars turn smoothly with no per-star work at any warp rate.
+		// The cache only re-propagates positions (on its worker) once
+		// the date has moved far enough.
+		double jd = simclock_jd(&sim_clock, now);
+		starcache_set_epoch(&star_cache, jd);
 
-				// dim stars early
-				if (mag > mag_cutoff)
-				{
-					cache_vis[i] = 0;
-					continue;
-				}
+		// Refits the Chebyshev window once a day
+		solsys_update(&solsys, jd);
 
-				float alt_deg, az_deg;
-				astro_radec_to_altaz(catalog.items[i].ra_hours,
-									catalog.items[i].dec_deg,
-									jd, LAT_DEG, LON_DEG,
-									&alt_deg, &az_deg);
+		// TODO: replace with GPS later
+		float eq_to_local[9];
+		astro_equatorial_to_local_matrix(jd, LAT_DEG, LON_DEG, eq_to_local);
 
-				if (alt_deg < 0.0f)
-				{
-					cache_vis[i] = 0;
-					continue;
-				}
+		// Same camera in the equatorial frame (transpose rotation)
+		astro_camera_rotated(&cam, eq_to_local, &cam_eq);
 
-				astro_altaz_to_unit(alt_deg, az_deg, &cache_lx[i], &cache_ly[i], &cache_lz[i]);
-				cache_vis[i] = 1;
-				cache_rad[i] = (unsigned char)mag_to_radius(mag);
-			}
-		}
+		// Local Up in the equatorial frame, for the horizon test
+		const float zen_x = eq_to_local[6];
+		const float zen_y = eq_to_local[7];
+		const float zen_z = eq_to_local[8];
+		prof_end(&prof, PROF_CAMERA);
 
 		// FPS calculated
 		frames++;
@@ -541,53 +745,100 @@ int main(void)
 			fps = frames * 1000.0f / (now - fpsLast);
 			frames = 0;
 			fpsLast = now;
+
+			if (show_prof)
+			{
+				for (int s = 0; s < PROF_STAGE_COUNT; s++)
+				{
+					prof_stats(&prof, (prof_stage_t)s, &prof_view[s]);
+				}
+			}
 		}
 
 		// Rendering phase.
+		prof_begin(&prof, PROF_DRAW);
 		SDL_SetRenderDrawColor(ren, 10, 10, 40, 255);
 		SDL_RenderClear(ren);
 
-		SDL_SetRenderDrawColor(ren, 120, 120, 120, 255);
-		draw_horizon(ren, rx, ry, rz, ux, uy, uz, fx, fy, fz, W, H, FOV);
+		// Grid lines first so stars land on top; RA/Dec stop at the horizon
+		const SDL_Color altaz_color = {40, 90, 60, 255};
+		const SDL_Color radec_color = {50, 70, 130, 255};
+		const SDL_Color equator_color = {150, 80, 80, 255};
+		const SDL_Color horizon_color = {120, 120, 120, 255};
+		if (grid_mode & 1)
+		{
+			grid_draw(&sky_grid, ren, GRID_ALTAZ, &cam, 0.0f, 0.0f, 0.0f, altaz_color);
+		}
+		if (grid_mode & 2)
+		{
+			grid_draw(&sky_grid, ren, GRID_RADEC, &cam_eq, zen_x, zen_y, zen_z, radec_color);
+			grid_draw(&sky_grid, ren, GRID_EQUATOR, &cam_eq, zen_x, zen_y, zen_z, equator_color);
+		}
+		grid_draw(&sky_grid, ren, GRID_HORIZON, &cam, 0.0f, 0.0f, 0.0f, horizon_color);
 
 		SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
-		draw_cardinals(ren, font, rx, ry, rz, ux, uy, uz, fx, fy, fz, W, H, FOV);
+		draw_cardinals(&text_cache, font, &cam);
 		SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
-		
-		for (size_t i = 0; i < catalog.count; i++)
+
+		prof_end(&prof, PROF_DRAW);
+
+		// Swap in the newest complete cache, if the worker has one, and
+		// hold it until the figures are drawn so both layers read the
+		// same generation. Cube mode only touches stars to refresh a
+		// stale face; the cube is in the equatorial frame, so it has no
+		// atmosphere.
+		const SDL_Color star_color = {255, 255, 255, 255};
+		const atmos_t *atm = use_atmos ? &atmos : NULL;
+		prof_begin(&prof, PROF_COLLECT);
+		const star_cache_buf_t *sc = starcache_acquire(&star_cache);
+		if (sc)
 		{
-			if (!cache_vis[i])
-			{
-				continue;
-			}
+			rebuild_ms = sc->build_ms;
+		}
+		int cube_frame = 0;
+		if (use_cube)
+		{
+			skycube_update(&sky_cube, ren, &sky_view, sc, n_bright, star_color, now);
+			cube_frame = skycube_ready(&sky_cube);
+		}
+		if (!cube_frame)
+		{
+			skyview_collect(&sky_view, sc, n_bright, &cam_eq, zen_x, zen_y, zen_z,
+							atm, mag_cutoff);
+		}
+		prof_end(&prof, PROF_COLLECT);
 
-			int px, py;
+		prof_begin(&prof, PROF_PROJECT);
+		if (!cube_frame)
+		{
+			skyview_project(&sky_view, &cam_eq);
+		}
+		prof_end(&prof, PROF_PROJECT);
 
-			if (!astro_project_dir(cache_lx[i], cache_ly[i], cache_lz[i],
-						rx, ry, rz,
-						ux, uy, uz,
-						fx, fy, fz,
-						W, H, FOV,
-						&px, &py, NULL))
-			{
-				continue;
-			}
+		prof_begin(&prof, PROF_DRAW);
 
-			int r = (int)cache_rad[i];
-			if (r <= 0)
-			{
-				SDL_RenderDrawPoint(ren, px, py);
-			}
-			else
-			{
-				for (int dy = -r; dy <= r; dy++)
-				{
-					for (int dx = -r; dx <= r; dx++)
-					{
-						SDL_RenderDrawPoint(ren, px + dx, py + dy);
-					}
-				}
-			}
+		// Figures under the stars, from the same cache vectors
+		if (show_const)
+		{
+			const SDL_Color const_color = {70, 110, 160, 255};
+			constellations_draw(&constellations, ren, sc, &cam_eq, zen_x, zen_y, zen_z,
+								cube_frame ? NULL : atm, const_color);
+		}
+		starcache_release(&star_cache);
+
+		if (cube_frame)
+		{
+			skycube_draw(&sky_cube, ren, &cam_eq, zen_x, zen_y, zen_z);
+		}
+		else
+		{
+			skyview_draw(&sky_view, ren, star_color);
+		}
+
+		if (show_bodies)
+		{
+			draw_bodies(&solsys, jd, &cam_eq, zen_x, zen_y, zen_z, atm, mag_cutoff,
+						&sky_view.batch, ren, &text_cache, font);
 		}
 
 		// Crosshair centered on screen.
@@ -599,22 +850,88 @@ int main(void)
 		char buf[128];
 		snprintf(buf, sizeof(buf),
         		"Yaw: %.1f  Pitch: %.1f  Roll: %.1f FPS: %.1f",
-         		yaw_s, pitch_s, roll_s, fps);
+         		yaw, pitch, roll, fps);
+
+		// Changes every frame: draw from the glyph atlas instead of caching
+		const SDL_Color white = {255, 255, 255, 255};
+		textcache_draw_glyphs(&text_cache, font, buf, white, 20, 20);
+
+		snprintf(buf, sizeof(buf), "M2P: %.1f ms  Predict: %s %.1f ms (lead %+.0f)",
+				m2p_ms, predict_on ? "on" : "off", predict_ms, predict_lead_ms);
+		textcache_draw_glyphs(&text_cache, font, buf, white, 20, 48);
+
+		// Simulated date and rate
+		{
+			int yr, mo, dy, hr, mi;
+			double sec;
+			astro_jd_to_calendar(jd, &yr, &mo, &dy, &hr, &mi, &sec);
+			double rate = simclock_rate(&sim_clock);
+			snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d UTC  x%.0f%s",
+					yr, mo, dy, hr, mi, (int)sec, rate, rate == 0.0 ? " (stopped)" : "");
+			textcache_draw_glyphs(&text_cache, font, buf, white, 20, H - 40);
+		}
+
+		// Profiler overlay: rolling stats over the last PROF_WINDOW frames
+		if (show_prof)
+		{
+			for (int s = 0; s < PROF_STAGE_COUNT; s++)
+			{
+				snprintf(buf, sizeof(buf),
+						"%-8s min %.2f  avg %.2f  p99 %.2f  max %.2f ms",
+						prof_stage_name((prof_stage_t)s),
+						prof_view[s].min_ms, prof_view[s].avg_ms,
+						prof_view[s].p99_ms, prof_view[s].max_ms);
+				textcache_draw_glyphs(&text_cache, font, buf, white, 20, 86 + s * 26);
+			}
 
-		renderText(ren, font, buf, 20, 20);
+			if (cube_frame)
+			{
+				snprintf(buf, sizeof(buf), "rebuild  %.2f ms (worker)  cube %d faces %d tris",
+						rebuild_ms, sky_cube.n_faces, sky_cube.n_tris);
+			}
+			else
+			{
+				snprintf(buf, sizeof(buf), "rebuild  %.2f ms (worker)", rebuild_ms);
+			}
+			textcache_draw_glyphs(&text_cache, font, buf, white, 20, 86 + PROF_STAGE_COUNT * 26);
+		}
+		prof_end(&prof, PROF_DRAW);
 
+		prof_begin(&prof, PROF_PRESENT);
 		SDL_RenderPresent(ren);
-		SDL_Delay(1); // Delay to avoid maxing out CPU.
+		prof_end(&prof, PROF_PRESENT);
+
+		// Measured motion-to-photon for this frame, and the render time
+		// the next prediction assumes
+		Uint64 present_t = SDL_GetPerformanceCounter();
+		m2p_ms = (float)((double)(present_t - sample_t) / ticks_per_ms);
+		render_ms_avg += 0.1f * ((float)((double)(present_t - t_camera) / ticks_per_ms) - render_ms_avg);
+		prof_value(&prof, PROF_LATENCY, m2p_ms);
+
+		prof_frame_end(&prof);
+		pacer_frame_done(&pacer);
 	}
 
 	// Cleanup resources.
-	free(cache_lx);
-	free(cache_ly);
-	free(cache_lz);
-	free(cache_vis);
-	free(cache_rad);
+	prof_close(&prof);
+	starcache_stop(&star_cache);
+	if (cube_ok)
+	{
+		skycube_free(&sky_cube);
+	}
+	if (const_ok)
+	{
+		constellations_free(&constellations);
+	}
+	grid_free(&sky_grid);
+	skyview_free(&sky_view);
+	textcache_free(&text_cache);
 
 	stars_free(&catalog);
+	if (imu_ok)
+	{
+		imusampler_stop(&imu_sampler);
+	}
 	imu_close();
 
 	TTF_CloseFont(font);
@@ -0,0 +1,145 @@
+#include "orient.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+float orient_wrap_deg_360(float a)
+{
+    while (a < 0.0f)
+    {
+        a += 360.0f;
+    }
+    while (a >= 360.0f)
+    {
+        a -= 360.0f;
+    }
+    return a;
+}
+
+float orient_angle_diff_deg(float a, float b)
+{
+    float d = a - b;
+    while (d > 180.0f)
+    {
+        d -= 360.0f;
+    }
+    while (d < -180.0f)
+    {
+        d += 360.0f;
+    }
+    return d;
+}
+
+quat_t orient_quat_identity(void)
+{
+    quat_t q = {1.0f, 0.0f, 0.0f, 0.0f};
+    return q;
+}
+
+quat_t orient_quat_mul(quat_t a, quat_t b)
+{
+    quat_t q;
+    q.w = a.w*b.w - a.x*b.x - a.y*b.y - a.z*b.z;
+    q.x = a.w*b.x + a.x*b.w + a.y*b.z - a.z*b.y;
+    q.y = a.w*b.y - a.x*b.z + a.y*b.w + a.z*b.x;
+    q.z = a.w*b.z + a.x*b.y - a.y*b.x + a.z*b.w;
+    return q;
+}
+
+quat_t orient_quat_normalize(quat_t q)
+{
+    float n = sqrtf(q.w*q.w + q.x*q.x + q.y*q.y + q.z*q.z);
+    if (n < 1e-12f)
+    {
+        return orient_quat_identity();
+    }
+
+    float inv = 1.0f / n;
+    q.w *= inv;
+    q.x *= inv;
+    q.y *= inv;
+    q.z *= inv;
+    return q;
+}
+
+quat_t orient_quat_axis_angle(float ax, float ay, float az, float angle_deg)
+{
+    float h = angle_deg * (float)M_PI / 360.0f;     // half angle, radians
+    float s = sinf(h);
+
+    quat_t q = {cosf(h), ax * s, ay * s, az * s};
+    return q;
+}
+
+quat_t orient_quat_from_euler(float yaw_deg, float pitch_deg, float roll_deg)
+{
+    // Yaw about Z, then pitch about X, then roll about Y, all about
+    // the fixed local axes
+    quat_t qy = orient_quat_axis_angle(0.0f, 0.0f, 1.0f, yaw_deg);
+    quat_t qp = orient_quat_axis_angle(1.0f, 0.0f, 0.0f, pitch_deg);
+    quat_t qr = orient_quat_axis_angle(0.0f, 1.0f, 0.0f, roll_deg);
+
+    return orient_quat_mul(qr, orient_quat_mul(qp, qy));
+}
+
+void orient_quat_to_euler(quat_t q, float *yaw_deg, float *pitch_deg, float *roll_deg)
+{
+    float rx, ry, rz, ux, uy, uz, fx, fy, fz;
+    orient_quat_basis(q, &rx, &ry, &rz, &ux, &uy, &uz, &fx, &fy, &fz);
+
+    // R = Ry(roll) Rx(pitch) Rz(yaw); its middle row is (ry, fy, uy)
+    const float r2d = 180.0f / (float)M_PI;
+    float sp = -uy;
+    if (sp > 1.0f)  sp = 1.0f;
+    if (sp < -1.0f) sp = -1.0f;
+
+    *yaw_deg = orient_wrap_deg_360(atan2f(ry, fy) * r2d);
+    *pitch_deg = asinf(sp) * r2d;
+    *roll_deg = atan2f(ux, uz) * r2d;
+}
+
+void orient_quat_rotate(quat_t q, float x, float y, float z,
+                        float *ox, float *oy, float *oz)
+{
+    // v' = v + 2w(u x v) + 2u x (u x v), u = (q.x, q.y, q.z)
+    float tx = 2.0f * (q.y*z - q.z*y);
+    float ty = 2.0f * (q.z*x - q.x*z);
+    float tz = 2.0f * (q.x*y - q.y*x);
+
+    *ox = x + q.w*tx + (q.y*tz - q.z*ty);
+    *oy = y + q.w*ty + (q.z*tx - q.x*tz);
+    *oz = z + q.w*tz + (q.x*ty - q.y*tx);
+}
+
+void orient_quat_basis(quat_t q,
+                       float *rx, float *ry, float *rz,
+                       float *ux, float *uy, float *uz,
+                       float *fx, float *fy, float *fz)
+{
+    // Columns of the rotation matrix
+    float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+    float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+    float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+
+    *rx = 1.0f - 2.0f*(yy + zz);
+    *ry = 2.0f*(xy + wz);
+    *rz = 2.0f*(xz - wy);
+
+    *fx = 2.0f*(xy - wz);
+    *fy = 1.0f - 2.0f*(xx + zz);
+    *fz = 2.0f*(yz + wx);
+
+    *ux = 2.0f*(xz + wy);
+    *uy = 2.0f*(yz - wx);
+    *uz = 1.0f - 2.0f*(xx + yy);
+}
+
+float orient_quat_heading(quat_t q)
+{
+    float fx, fy, fz;
+    orient_quat_rotate(q, 0.0f, 1.0f, 0.0f, &fx, &fy, &fz);
+
+    return orient_wrap_deg_360(atan2f(-fx, fy) * 180.0f / (float)M_PI);
+}
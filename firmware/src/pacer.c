@@ -0,0 +1,119 @@
+#include "pacer.h"
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Angle (degrees) of the rotation between two unit quaternions
+static float quat_angle_deg(quat_t a, quat_t b)
+{
+    float d = fabsf(a.w*b.w + a.x*b.x + a.y*b.y + a.z*b.z);
+    if (d > 1.0f)
+    {
+        d = 1.0f;
+    }
+    return 2.0f * acosf(d) * 180.0f / (float)M_PI;
+}
+
+static Uint64 period_ticks(const frame_pacer_t *p, int fps)
+{
+    return (fps > 0) ? p->freq / (Uint64)fps : 0;
+}
+
+void pacer_init(frame_pacer_t *p, int target_fps, int idle_fps, int vsync_hz)
+{
+    p->target_fps = target_fps;
+    p->idle_fps = idle_fps;
+    p->vsync_hz = vsync_hz;
+
+    p->freq = SDL_GetPerformanceFrequency();
+    p->next = SDL_GetPerformanceCounter();
+    p->last_frame = 0;
+
+    p->ref_q = orient_quat_identity();
+    p->have_ref = 0;
+    p->still_since = SDL_GetTicks();
+    p->idle = 0;
+}
+
+int pacer_update(frame_pacer_t *p, quat_t q, int busy, Uint32 now_ms)
+{
+    // The reference only moves on motion, so slow drift still adds up
+    if (!p->have_ref || busy || quat_angle_deg(q, p->ref_q) > PACER_IDLE_DEG)
+    {
+        p->ref_q = q;
+        p->have_ref = 1;
+        p->still_since = now_ms;
+
+        if (p->idle)
+        {
+            // Resume now rather than at the next idle deadline
+            p->idle = 0;
+            p->next = SDL_GetPerformanceCounter();
+        }
+        return 0;
+    }
+
+    if (now_ms - p->still_since >= PACER_IDLE_AFTER_MS)
+    {
+        p->idle = 1;
+    }
+    return p->idle;
+}
+
+int pacer_frame_due(frame_pacer_t *p)
+{
+    if (!p->idle)
+    {
+        return 1;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    return now - p->last_frame >= period_ticks(p, p->idle_fps);
+}
+
+void pacer_idle_wait(frame_pacer_t *p)
+{
+    (void)p;
+
+    // Returns early on input; the event stays queued for the loop
+    SDL_WaitEventTimeout(NULL, PACER_IDLE_POLL_MS);
+}
+
+void pacer_frame_done(frame_pacer_t *p)
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+    p->last_frame = now;
+
+    if (p->idle)
+    {
+        return;
+    }
+
+    // Vsync already holds the loop to the display rate
+    if (p->target_fps <= 0 || (p->vsync_hz > 0 && p->target_fps >= p->vsync_hz))
+    {
+        p->next = now;
+        return;
+    }
+
+    Uint64 period = period_ticks(p, p->target_fps);
+    p->next += period;
+
+    // Fell behind (slow frame or just resumed): restart the schedule
+    if (now >= p->next)
+    {
+        if (now - p->next > period)
+        {
+            p->next = now;
+        }
+        return;
+    }
+
+    Uint32 wait_ms = (Uint32)((p->next - now) * 1000 / p->freq);
+    if (wait_ms > 0)
+    {
+        SDL_Delay(wait_ms);
+    }
+}
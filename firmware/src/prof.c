@@ -0,0 +1,196 @@
+#include "prof.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *stage_names[PROF_STAGE_COUNT] = {
+    "imu", "orient", "camera", "collect", "project", "draw", "present", "frame", "m2p"
+};
+
+static int cmp_float(const void *a, const void *b)
+{
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+
+    return (fa > fb) - (fa < fb);
+}
+
+static double ticks_to_us(const profiler_t *p, Uint64 t)
+{
+    return (double)(t - p->origin) * p->tick_ms * 1000.0;
+}
+
+static void trace_event(profiler_t *p, prof_stage_t s, Uint64 t0, Uint64 t1)
+{
+    if (!p->trace || p->trace_fmt != PROF_TRACE_CHROME)
+    {
+        return;
+    }
+
+    fprintf(p->trace,
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%lu}}",
+            p->trace_events ? ",\n" : "",
+            stage_names[s], ticks_to_us(p, t0),
+            (double)(t1 - t0) * p->tick_ms * 1000.0, p->frame);
+    p->trace_events++;
+}
+
+void prof_init(profiler_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->origin = SDL_GetPerformanceCounter();
+    p->tick_ms = 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+int prof_open_trace(profiler_t *p, const char *path)
+{
+    prof_close(p);
+
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        perror("prof_open_trace");
+        return -1;
+    }
+
+    const char *ext = strrchr(path, '.');
+    p->trace = f;
+    p->trace_events = 0;
+    p->trace_fmt = (ext && strcmp(ext, ".csv") == 0) ? PROF_TRACE_CSV : PROF_TRACE_CHROME;
+
+    if (p->trace_fmt == PROF_TRACE_CSV)
+    {
+        fprintf(f, "frame,t_ms");
+        for (int s = 0; s < PROF_STAGE_COUNT; s++)
+        {
+            fprintf(f, ",%s_ms", stage_names[s]);
+        }
+        fprintf(f, "\n");
+    }
+    else
+    {
+        fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    }
+
+    return 0;
+}
+
+void prof_begin(profiler_t *p, prof_stage_t s)
+{
+    p->start[s] = SDL_GetPerformanceCounter();
+}
+
+void prof_end(profiler_t *p, prof_stage_t s)
+{
+    prof_add(p, s, p->start[s], SDL_GetPerformanceCounter());
+}
+
+void prof_add(profiler_t *p, prof_stage_t s, Uint64 t0, Uint64 t1)
+{
+    p->cur[s] += (float)((double)(t1 - t0) * p->tick_ms);
+    trace_event(p, s, t0, t1);
+}
+
+void prof_value(profiler_t *p, prof_stage_t s, float ms)
+{
+    p->cur[s] = ms;
+
+    if (p->trace && p->trace_fmt == PROF_TRACE_CHROME)
+    {
+        // Counter track rather than a slice
+        fprintf(p->trace,
+                "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":1,"
+                "\"ts\":%.1f,\"args\":{\"ms\":%.3f}}",
+                p->trace_events ? ",\n" : "",
+                stage_names[s], ticks_to_us(p, SDL_GetPerformanceCounter()), ms);
+        p->trace_events++;
+    }
+}
+
+void prof_frame_begin(profiler_t *p)
+{
+    for (int s = 0; s < PROF_STAGE_COUNT; s++)
+    {
+        p->cur[s] = 0.0f;
+    }
+
+    prof_begin(p, PROF_FRAME);
+}
+
+void prof_frame_end(profiler_t *p)
+{
+    prof_end(p, PROF_FRAME);
+
+    for (int s = 0; s < PROF_STAGE_COUNT; s++)
+    {
+        p->ring[s][p->head] = p->cur[s];
+    }
+
+    p->head = (p->head + 1) % PROF_WINDOW;
+    if (p->filled < PROF_WINDOW)
+    {
+        p->filled++;
+    }
+
+    if (p->trace && p->trace_fmt == PROF_TRACE_CSV)
+    {
+        fprintf(p->trace, "%lu,%.3f", p->frame,
+                ticks_to_us(p, p->start[PROF_FRAME]) / 1000.0);
+        for (int s = 0; s < PROF_STAGE_COUNT; s++)
+        {
+            fprintf(p->trace, ",%.4f", p->cur[s]);
+        }
+        fprintf(p->trace, "\n");
+    }
+
+    p->frame++;
+}
+
+void prof_stats(const profiler_t *p, prof_stage_t s, prof_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    size_t n = p->filled;
+    if (n == 0)
+    {
+        return;
+    }
+
+    // Sorted copy of the window: min, max and p99 fall out directly
+    float sorted[PROF_WINDOW];
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        sorted[i] = p->ring[s][i];
+        sum += sorted[i];
+    }
+    qsort(sorted, n, sizeof(float), cmp_float);
+
+    size_t k = (n * 99 + 99) / 100;     // ceil(0.99 * n)
+    out->min_ms = sorted[0];
+    out->avg_ms = (float)(sum / (double)n);
+    out->p99_ms = sorted[k - 1];
+    out->max_ms = sorted[n - 1];
+}
+
+const char *prof_stage_name(prof_stage_t s)
+{
+    return (s >= 0 && s < PROF_STAGE_COUNT) ? stage_names[s] : "?";
+}
+
+void prof_close(profiler_t *p)
+{
+    if (!p->trace)
+    {
+        return;
+    }
+
+    if (p->trace_fmt == PROF_TRACE_CHROME)
+    {
+        fprintf(p->trace, "\n]}\n");
+    }
+
+    fclose(p->trace);
+    p->trace = NULL;
+    p->trace_fmt = PROF_TRACE_NONE;
+}
@@ -0,0 +1,68 @@
+#include "simclock.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void simclock_init(sim_clock_t *c, double jd_utc, uint32_t now_ms)
+{
+    memset(c, 0, sizeof(*c));
+    c->anchor_jd = jd_utc;
+    c->anchor_ms = now_ms;
+    c->step = 1;
+}
+
+double simclock_rate(const sim_clock_t *c)
+{
+    if (c->paused || c->step == 0)
+    {
+        return 0.0;
+    }
+
+    double r = pow(10.0, abs(c->step) - 1);
+    return (c->step < 0) ? -r : r;
+}
+
+double simclock_jd(const sim_clock_t *c, uint32_t now_ms)
+{
+    // Unsigned difference stays right across the 49-day tick wrap
+    uint32_t elapsed_ms = now_ms - c->anchor_ms;
+    return c->anchor_jd + (double)elapsed_ms * simclock_rate(c) / 86400000.0;
+}
+
+// Current simulated date becomes the anchor for the new rate
+static void reanchor(sim_clock_t *c, uint32_t now_ms)
+{
+    c->anchor_jd = simclock_jd(c, now_ms);
+    c->anchor_ms = now_ms;
+}
+
+void simclock_step(sim_clock_t *c, int delta, uint32_t now_ms)
+{
+    reanchor(c, now_ms);
+
+    c->step += delta;
+    if (c->step > SIMCLOCK_MAX_STEP)
+    {
+        c->step = SIMCLOCK_MAX_STEP;
+    }
+    if (c->step < -SIMCLOCK_MAX_STEP)
+    {
+        c->step = -SIMCLOCK_MAX_STEP;
+    }
+}
+
+void simclock_toggle_pause(sim_clock_t *c, uint32_t now_ms)
+{
+    reanchor(c, now_ms);
+    c->paused = !c->paused;
+}
+
+void simclock_reset(sim_clock_t *c, double jd_utc, uint32_t now_ms)
+{
+    simclock_init(c, jd_utc, now_ms);
+}
+
+int simclock_fast(const sim_clock_t *c)
+{
+    return fabs(simclock_rate(c)) > 1.0;
+}
@@ -0,0 +1,407 @@
+#include "skycube.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define ALL_FACES 0x3Fu
+
+// Mesh triangles with a vertex this close to 90 deg off-axis are dropped.
+// They are far outside any usable field of view.
+#define SKYCUBE_NEAR 0.05f
+
+// Face forward and up axes (equatorial); right = forward x up
+static const float face_axes[6][2][3] = {
+    {{ 1, 0, 0}, {0, 0, 1}},
+    {{-1, 0, 0}, {0, 0, 1}},
+    {{ 0, 1, 0}, {0, 0, 1}},
+    {{ 0,-1, 0}, {0, 0, 1}},
+    {{ 0, 0, 1}, {1, 0, 0}},
+    {{ 0, 0,-1}, {1, 0, 0}}
+};
+
+// One mesh point: direction, screen position, face texture position, height above horizon
+typedef struct
+{
+    float d[3];
+    float sx, sy;
+    float u, v;
+    float h;
+} cube_pt_t;
+
+static float dot3(const float a[3], float x, float y, float z)
+{
+    return a[0]*x + a[1]*y + a[2]*z;
+}
+
+void skycube_free(sky_cube_t *c)
+{
+    if (!c)
+    {
+        return;
+    }
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (c->face[i])
+        {
+            SDL_DestroyTexture(c->face[i]);
+        }
+    }
+    free(c->verts);
+    memset(c, 0, sizeof(*c));
+}
+
+int skycube_init(sky_cube_t *c, SDL_Renderer *ren, int size, Uint32 refresh_ms)
+{
+    if (!c || !ren)
+    {
+        return -1;
+    }
+
+    memset(c, 0, sizeof(*c));
+    c->size = size > 0 ? size : SKYCUBE_FACE_SIZE;
+    c->refresh_ms = refresh_ms;
+    c->dirty = ALL_FACES;
+
+    if (!SDL_RenderTargetSupported(ren))
+    {
+        fprintf(stderr, "skycube: renderer has no render targets\n");
+        return -1;
+    }
+
+    // Stars are drawn into transparent black, so texels are already
+    // premultiplied; add them as-is. Plain ADD (which multiplies by
+    // alpha again) is the fallback where custom modes are missing.
+    SDL_BlendMode add_premul = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ZERO, SDL_BLENDFACTOR_ONE, SDL_BLENDOPERATION_ADD);
+
+    for (int i = 0; i < 6; i++)
+    {
+        c->face[i] = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                       c->size, c->size);
+        if (!c->face[i])
+        {
+            fprintf(stderr, "skycube: face texture: %s\n", SDL_GetError());
+            skycube_free(c);
+            return -1;
+        }
+
+        if (SDL_SetTextureBlendMode(c->face[i], add_premul) != 0)
+        {
+            SDL_SetTextureBlendMode(c->face[i], SDL_BLENDMODE_ADD);
+        }
+        SDL_SetTextureScaleMode(c->face[i], SDL_ScaleModeLinear);
+    }
+
+    // The face cameras see SKYCUBE_GUARD_PX past the 90 deg edge; the
+    // mesh only samples inside it, so seams never cut a sprite.
+    float half = 0.5f * (float)c->size;
+    float g = half / (half - (float)SKYCUBE_GUARD_PX);
+    float fov = 2.0f * atanf(g) * 180.0f / (float)M_PI;
+
+    for (int i = 0; i < 6; i++)
+    {
+        const float *f = face_axes[i][0];
+        const float *up = face_axes[i][1];
+        float r[3] = {
+            f[1]*up[2] - f[2]*up[1],
+            f[2]*up[0] - f[0]*up[2],
+            f[0]*up[1] - f[1]*up[0]
+        };
+
+        astro_camera_init(&c->face_cam[i], c->size, c->size, fov);
+        astro_camera_set_basis(&c->face_cam[i], r[0], r[1], r[2],
+                               up[0], up[1], up[2], f[0], f[1], f[2]);
+
+        for (int j = 0; j <= SKYCUBE_GRID; j++)
+        {
+            for (int k = 0; k <= SKYCUBE_GRID; k++)
+            {
+                int n = j * (SKYCUBE_GRID + 1) + k;
+                float a = -1.0f + 2.0f * (float)k / SKYCUBE_GRID;
+                float b =  1.0f - 2.0f * (float)j / SKYCUBE_GRID;
+
+                float x = f[0] + a*r[0] + b*up[0];
+                float y = f[1] + a*r[1] + b*up[1];
+                float z = f[2] + a*r[2] + b*up[2];
+                float inv = 1.0f / sqrtf(x*x + y*y + z*z);
+
+                c->dir[i][n][0] = x * inv;
+                c->dir[i][n][1] = y * inv;
+                c->dir[i][n][2] = z * inv;
+
+                // Same for every face
+                c->tu[n] = 0.5f + 0.5f * a / g;
+                c->tv[n] = 0.5f - 0.5f * b / g;
+            }
+        }
+    }
+
+    // Worst case: every cell's two triangles clip to quads
+    c->vert_cap = SKYCUBE_GRID * SKYCUBE_GRID * 2 * 6;
+    c->verts = (SDL_Vertex*)malloc(sizeof(SDL_Vertex) * (size_t)c->vert_cap);
+    if (!c->verts)
+    {
+        fprintf(stderr, "skycube: out of memory\n");
+        skycube_free(c);
+        return -1;
+    }
+
+    return 0;
+}
+
+void skycube_invalidate(sky_cube_t *c)
+{
+    c->dirty = ALL_FACES;
+}
+
+int skycube_ready(const sky_cube_t *c)
+{
+    return c->valid == ALL_FACES;
+}
+
+int skycube_update(sky_cube_t *c, SDL_Renderer *ren, sky_view_t *v,
+                   const star_cache_buf_t *sc, size_t n_bright,
+                   SDL_Color color, Uint32 now_ms)
+{
+    if (!sc)
+    {
+        return 0;
+    }
+
+    if (sc->generation != c->generation || n_bright != c->n_bright ||
+        (c->refresh_ms > 0 && now_ms - c->last_refresh >= c->refresh_ms))
+    {
+        c->generation = sc->generation;
+        c->n_bright = n_bright;
+        c->last_refresh = now_ms;
+        c->dirty = ALL_FACES;
+    }
+
+    if (!c->dirty)
+    {
+        return 0;
+    }
+
+    int i = 0;
+    while (!(c->dirty & (1u << i)))
+    {
+        i++;
+    }
+
+    SDL_Texture *prev = SDL_GetRenderTarget(ren);
+    if (SDL_SetRenderTarget(ren, c->face[i]) != 0)
+    {
+        return 0;
+    }
+
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 0);
+    SDL_RenderClear(ren);
+
+    // Whole sphere: a zero Up vector disables the horizon test
+    skyview_collect(v, sc, n_bright, &c->face_cam[i], 0.0f, 0.0f, 0.0f, NULL, 0.0f);
+    skyview_project(v, &c->face_cam[i]);
+    skyview_draw(v, ren, color);
+
+    SDL_SetRenderTarget(ren, prev);
+
+    c->dirty &= ~(1u << i);
+    c->valid |= 1u << i;
+    return 1;
+}
+
+// Screen and face texture position of direction p->d
+static void place_pt(cube_pt_t *p, const camera_t *cam, const camera_t *fc, float g)
+{
+    float x = p->d[0], y = p->d[1], z = p->d[2];
+
+    float inv = cam->focal / (cam->fx*x + cam->fy*y + cam->fz*z);
+    p->sx = (cam->rx*x + cam->ry*y + cam->rz*z) * inv + cam->cx;
+    p->sy = -(cam->ux*x + cam->uy*y + cam->uz*z) * inv + cam->cy;
+
+    float finv = 1.0f / (fc->fx*x + fc->fy*y + fc->fz*z);
+    p->u = 0.5f + 0.5f * (fc->rx*x + fc->ry*y + fc->rz*z) * finv / g;
+    p->v = 0.5f - 0.5f * (fc->ux*x + fc->uy*y + fc->uz*z) * finv / g;
+}
+
+static void put_vert(SDL_Vertex *out, const cube_pt_t *p)
+{
+    out->position.x = p->sx;
+    out->position.y = p->sy;
+    out->color.r = out->color.g = out->color.b = out->color.a = 255;
+    out->tex_coord.x = p->u;
+    out->tex_coord.y = p->v;
+}
+
+/*
+ * Appends triangle t clipped to h >= 0. The horizon is a
+ * great circle, so the crossing on each edge is found on the sphere
+ * and projected, which keeps the clipped edge exact at any grid size.
+ */
+static int add_clipped(SDL_Vertex *out, const cube_pt_t *t[3],
+                       const camera_t *cam, const camera_t *fc, float g)
+{
+    cube_pt_t poly[4];
+    int n = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        const cube_pt_t *a = t[i];
+        const cube_pt_t *b = t[(i + 1) % 3];
+
+        if (a->h >= 0.0f)
+        {
+            poly[n++] = *a;
+        }
+
+        if ((a->h >= 0.0f) != (b->h >= 0.0f))
+        {
+            float s = a->h / (a->h - b->h);
+            cube_pt_t *p = &poly[n++];
+            for (int k = 0; k < 3; k++)
+            {
+                p->d[k] = a->d[k] + s * (b->d[k] - a->d[k]);
+            }
+            p->h = 0.0f;
+            place_pt(p, cam, fc, g);
+        }
+    }
+
+    int count = 0;
+    for (int i = 1; i + 1 < n; i++)
+    {
+        put_vert(&out[count++], &poly[0]);
+        put_vert(&out[count++], &poly[i]);
+        put_vert(&out[count++], &poly[i + 1]);
+    }
+    return count;
+}
+
+// 1 if all three points are beyond the same screen edge
+static int tri_offscreen(const cube_pt_t *t[3], const camera_t *cam)
+{
+    if (t[0]->sx < 0 && t[1]->sx < 0 && t[2]->sx < 0) return 1;
+    if (t[0]->sy < 0 && t[1]->sy < 0 && t[2]->sy < 0) return 1;
+    if (t[0]->sx > cam->w && t[1]->sx > cam->w && t[2]->sx > cam->w) return 1;
+    if (t[0]->sy > cam->h && t[1]->sy > cam->h && t[2]->sy > cam->h) return 1;
+    return 0;
+}
+
+int skycube_draw(sky_cube_t *c, SDL_Renderer *ren, const camera_t *cam,
+                 float zx, float zy, float zz)
+{
+    c->n_faces = 0;
+    c->n_tris = 0;
+
+    if (!c->valid)
+    {
+        return -1;
+    }
+
+    float half = 0.5f * (float)c->size;
+    float g = half / (half - (float)SKYCUBE_GUARD_PX);
+    cube_pt_t pts[SKYCUBE_VERTS];
+    float cz[SKYCUBE_VERTS];
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (!(c->valid & (1u << i)))
+        {
+            continue;
+        }
+
+        // Corners are 54.7 deg from the face center: past 144.7 deg
+        // the whole face is behind the camera
+        const camera_t *fc = &c->face_cam[i];
+        if (fc->fx*cam->fx + fc->fy*cam->fy + fc->fz*cam->fz < -0.82f)
+        {
+            continue;
+        }
+
+        for (int n = 0; n < SKYCUBE_VERTS; n++)
+        {
+            const float *d = c->dir[i][n];
+            cube_pt_t *p = &pts[n];
+
+            p->d[0] = d[0];
+            p->d[1] = d[1];
+            p->d[2] = d[2];
+            p->u = c->tu[n];
+            p->v = c->tv[n];
+            p->h = dot3(d, zx, zy, zz);
+
+            cz[n] = cam->fx*d[0] + cam->fy*d[1] + cam->fz*d[2];
+            if (cz[n] > SKYCUBE_NEAR)
+            {
+                float inv = cam->focal / cz[n];
+                p->sx = (cam->rx*d[0] + cam->ry*d[1] + cam->rz*d[2]) * inv + cam->cx;
+                p->sy = -(cam->ux*d[0] + cam->uy*d[1] + cam->uz*d[2]) * inv + cam->cy;
+            }
+        }
+
+        int count = 0;
+        for (int j = 0; j < SKYCUBE_GRID; j++)
+        {
+            for (int k = 0; k < SKYCUBE_GRID; k++)
+            {
+                int n00 = j * (SKYCUBE_GRID + 1) + k;
+                int n01 = n00 + 1;
+                int n10 = n00 + SKYCUBE_GRID + 1;
+                int n11 = n10 + 1;
+
+                if (cz[n00] <= SKYCUBE_NEAR || cz[n01] <= SKYCUBE_NEAR ||
+                    cz[n10] <= SKYCUBE_NEAR || cz[n11] <= SKYCUBE_NEAR)
+                {
+                    continue;
+                }
+
+                const cube_pt_t *tris[2][3] = {
+                    {&pts[n00], &pts[n01], &pts[n11]},
+                    {&pts[n00], &pts[n11], &pts[n10]}
+                };
+
+                for (int t = 0; t < 2; t++)
+                {
+                    const cube_pt_t **tri = tris[t];
+
+                    if (tri_offscreen(tri, cam))
+                    {
+                        continue;
+                    }
+
+                    if (tri[0]->h >= 0.0f && tri[1]->h >= 0.0f && tri[2]->h >= 0.0f)
+                    {
+                        put_vert(&c->verts[count++], tri[0]);
+                        put_vert(&c->verts[count++], tri[1]);
+                        put_vert(&c->verts[count++], tri[2]);
+                    }
+                    else if (tri[0]->h >= 0.0f || tri[1]->h >= 0.0f || tri[2]->h >= 0.0f)
+                    {
+                        count += add_clipped(&c->verts[count], tri, cam, fc, g);
+                    }
+                }
+            }
+        }
+
+        if (count == 0)
+        {
+            continue;
+        }
+
+        if (SDL_RenderGeometry(ren, c->face[i], c->verts, count, NULL, 0) != 0)
+        {
+            return -1;
+        }
+
+        c->n_faces++;
+        c->n_tris += count / 3;
+    }
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include "skyindex.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEG2RAD_F(x) ((float)(x) * ((float)M_PI / 180.0f))
+
+/*
+ * Face numbering follows the dominant axis:
+ *   0:+X 1:-X 2:+Y 3:-Y 4:+Z 5:-Z
+ * (u, v) are the two remaining components divided by the dominant one,
+ * taken in x, y, z order.
+ */
+static void dir_to_face_uv(float x, float y, float z, int *face, float *u, float *v)
+{
+    float axv = fabsf(x), ayv = fabsf(y), azv = fabsf(z);
+
+    if (axv >= ayv && axv >= azv)
+    {
+        *face = (x >= 0.f) ? 0 : 1;
+        *u = y / axv;
+        *v = z / axv;
+    }
+    else if (ayv >= azv)
+    {
+        *face = (y >= 0.f) ? 2 : 3;
+        *u = x / ayv;
+        *v = z / ayv;
+    }
+    else
+    {
+        *face = (z >= 0.f) ? 4 : 5;
+        *u = x / azv;
+        *v = y / azv;
+    }
+}
+
+static void face_uv_to_dir(int face, float u, float v, float *x, float *y, float *z)
+{
+    float s = (face & 1) ? -1.f : 1.f;
+
+    switch (face >> 1)
+    {
+        case 0:  *x = s;  *y = u;  *z = v;  break;
+        case 1:  *x = u;  *y = s;  *z = v;  break;
+        default: *x = u;  *y = v;  *z = s;  break;
+    }
+
+    float len = sqrtf((*x)*(*x) + (*y)*(*y) + (*z)*(*z));
+    *x /= len;
+    *y /= len;
+    *z /= len;
+}
+
+// Equal-angle remap: tile edges at even steps of atan(u)
+static int uv_to_cell(float u, int res)
+{
+    float a = atanf(u) * (4.0f / (float)M_PI);     // -1..1
+    int c = (int)((a + 1.0f) * 0.5f * (float)res);
+    if (c < 0)    c = 0;
+    if (c >= res) c = res - 1;
+    return c;
+}
+
+static float cell_to_uv(float c, int res)
+{
+    float a = (c / (float)res) * 2.0f - 1.0f;
+    return tanf(a * ((float)M_PI / 4.0f));
+}
+
+uint32_t skyindex_tile_of(const sky_index_t *idx, float x, float y, float z)
+{
+    int face;
+    float u, v;
+    dir_to_face_uv(x, y, z, &face, &u, &v);
+
+    int res = idx->res;
+    return (uint32_t)((face * res + uv_to_cell(v, res)) * res + uv_to_cell(u, res));
+}
+
+static void compute_tile_bounds(sky_index_t *idx)
+{
+    int res = idx->res;
+
+    for (int face = 0; face < 6; face++)
+    {
+        for (int j = 0; j < res; j++)
+        {
+            for (int i = 0; i < res; i++)
+            {
+                size_t t = (size_t)(face * res + j) * res + i;
+
+                float cx, cy, cz;
+                face_uv_to_dir(face, cell_to_uv(i + 0.5f, res), cell_to_uv(j + 0.5f, res),
+                               &cx, &cy, &cz);
+
+                // Farthest point of a spherical quad from its centre is a corner
+                float min_dot = 1.0f;
+                for (int k = 0; k < 4; k++)
+                {
+                    float px, py, pz;
+                    face_uv_to_dir(face, cell_to_uv((float)(i + (k & 1)), res),
+                                   cell_to_uv((float)(j + (k >> 1)), res), &px, &py, &pz);
+                    float d = px*cx + py*cy + pz*cz;
+                    if (d < min_dot) min_dot = d;
+                }
+
+                // Small pad covers float error in the bucketing
+                float r = acosf(min_dot) + DEG2RAD_F(0.05f);
+
+                idx->tile_cx[t] = cx;
+                idx->tile_cy[t] = cy;
+                idx->tile_cz[t] = cz;
+                idx->tile_cos_r[t] = cosf(r);
+                idx->tile_sin_r[t] = sinf(r);
+            }
+        }
+    }
+}
+
+int skyindex_build(sky_index_t *idx, const float *x, const float *y, const float *z,
+                   size_t count, int res)
+{
+    if (!idx || res <= 0 || (count > 0 && (!x || !y || !z)))
+    {
+        return -1;
+    }
+
+    memset(idx, 0, sizeof(*idx));
+    idx->res = res;
+    idx->tile_count = (size_t)6 * res * res;
+    idx->count = count;
+
+    size_t tc = idx->tile_count;
+    idx->tile_start = (uint32_t*)calloc(tc + 1, sizeof(uint32_t));
+    idx->order = (uint32_t*)malloc(sizeof(uint32_t) * (count ? count : 1));
+    idx->tile_cx = (float*)malloc(sizeof(float) * tc);
+    idx->tile_cy = (float*)malloc(sizeof(float) * tc);
+    idx->tile_cz = (float*)malloc(sizeof(float) * tc);
+    idx->tile_cos_r = (float*)malloc(sizeof(float) * tc);
+    idx->tile_sin_r = (float*)malloc(sizeof(float) * tc);
+    uint32_t *tile_of = (uint32_t*)malloc(sizeof(uint32_t) * (count ? count : 1));
+
+    if (!idx->tile_start || !idx->order || !idx->tile_cx || !idx->tile_cy ||
+        !idx->tile_cz || !idx->tile_cos_r || !idx->tile_sin_r || !tile_of)
+    {
+        free(tile_of);
+        skyindex_free(idx);
+        return -1;
+    }
+
+    compute_tile_bounds(idx);
+
+    // Counting sort by tile. Stable, so stars stay in catalog order per tile.
+    for (size_t i = 0; i < count; i++)
+    {
+        tile_of[i] = skyindex_tile_of(idx, x[i], y[i], z[i]);
+        idx->tile_start[tile_of[i] + 1]++;
+    }
+
+    for (size_t t = 0; t < tc; t++)
+    {
+        idx->tile_start[t + 1] += idx->tile_start[t];
+    }
+
+    // tile_start[t] doubles as the fill cursor, then gets shifted back
+    for (size_t i = 0; i < count; i++)
+    {
+        idx->order[idx->tile_start[tile_of[i]]++] = (uint32_t)i;
+    }
+
+    for (size_t t = tc; t > 0; t--)
+    {
+        idx->tile_start[t] = idx->tile_start[t - 1];
+    }
+    idx->tile_start[0] = 0;
+
+    free(tile_of);
+    return 0;
+}
+
+size_t skyindex_query(const sky_index_t *idx, float ax, float ay, float az,
+                      float half_angle_deg, uint32_t *out_tiles, size_t max_tiles)
+{
+    if (!idx || !out_tiles)
+    {
+        return 0;
+    }
+
+    float h = DEG2RAD_F(half_angle_deg);
+    float ch = cosf(h), sh = sinf(h);
+    size_t n = 0;
+
+    for (size_t t = 0; t < idx->tile_count && n < max_tiles; t++)
+    {
+        if (idx->tile_start[t] == idx->tile_start[t + 1])
+        {
+            continue;
+        }
+
+        // Tile overlaps the cone when angle(axis, centre) <= h + r,
+        // i.e. dot >= cos(h + r). Past 180 deg everything overlaps.
+        float d = ax*idx->tile_cx[t] + ay*idx->tile_cy[t] + az*idx->tile_cz[t];
+        float cr = idx->tile_cos_r[t], sr = idx->tile_sin_r[t];
+        float cos_sum = ch*cr - sh*sr;
+        float sin_sum = sh*cr + ch*sr;
+
+        if (sin_sum < 0.f || d >= cos_sum)
+        {
+            out_tiles[n++] = (uint32_t)t;
+        }
+    }
+
+    return n;
+}
+
+void skyindex_free(sky_index_t *idx)
+{
+    if (!idx)
+    {
+        return;
+    }
+
+    free(idx->tile_start);
+    free(idx->order);
+    free(idx->tile_cx);
+    free(idx->tile_cy);
+    free(idx->tile_cz);
+    free(idx->tile_cos_r);
+    free(idx->tile_sin_r);
+    memset(idx, 0, sizeof(*idx));
+}
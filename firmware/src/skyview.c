@@ -0,0 +1,222 @@
+#include "skyview.h"
+#include "astro.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int skyview_init(sky_view_t *v, SDL_Renderer *ren, size_t max_stars)
+{
+    if (!v)
+    {
+        return -1;
+    }
+
+    memset(v, 0, sizeof(*v));
+
+    size_t n = max_stars ? max_stars : 1;
+    v->cand_x = (float*)malloc(sizeof(float) * n);
+    v->cand_y = (float*)malloc(sizeof(float) * n);
+    v->cand_z = (float*)malloc(sizeof(float) * n);
+    v->cand_rad = (unsigned char*)malloc(sizeof(unsigned char) * n);
+    v->cand_xy = (float*)malloc(sizeof(float) * 2 * n);
+    v->cand_vis = (unsigned char*)malloc(sizeof(unsigned char) * n);
+    v->view_tiles = (uint32_t*)malloc(sizeof(uint32_t) * 6 *
+                                      STARCACHE_INDEX_RES * STARCACHE_INDEX_RES);
+    v->cand_cap = n;
+
+    if (!v->cand_x || !v->cand_y || !v->cand_z || !v->cand_rad ||
+        !v->cand_xy || !v->cand_vis || !v->view_tiles)
+    {
+        fprintf(stderr, "skyview: out of memory\n");
+        skyview_free(v);
+        return -1;
+    }
+
+    // No renderer (benchmark --null): collect/project only
+    if (ren && starbatch_init(&v->batch, ren) != 0)
+    {
+        skyview_free(v);
+        return -1;
+    }
+
+    return 0;
+}
+
+// 1 if some part of the tile's cap is on the inner side of every frustum plane
+static int tile_in_frustum(const sky_index_t *idx, uint32_t t, const camera_t *cam)
+{
+    for (int p = 0; p < 4; p++)
+    {
+        const float *n = cam->planes[p];
+        float d = n[0]*idx->tile_cx[t] + n[1]*idx->tile_cy[t] + n[2]*idx->tile_cz[t];
+
+        // Whole cap outside: its center is more than its radius past the plane
+        if (d < -idx->tile_sin_r[t])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+size_t skyview_collect(sky_view_t *v, const star_cache_buf_t *sc, size_t n_bright,
+                       const camera_t *cam, float zx, float zy, float zz,
+                       const atmos_t *atm, float mag_limit)
+{
+    v->n_tiles = 0;
+    v->n_cand = 0;
+    v->n_visible = 0;
+
+    if (!sc)
+    {
+        return 0;
+    }
+
+    // Find the sky tiles under the view cone (index is equatorial)
+    const sky_index_t *idx = &sc->index;
+    size_t n_cone = skyindex_query(idx, cam->fx, cam->fy, cam->fz, cam->half_angle_deg,
+                                   v->view_tiles, idx->tile_count);
+
+    // The cone reaches past the screen edges; the frustum trims the sides
+    size_t n_tiles = 0;
+    for (size_t t = 0; t < n_cone; t++)
+    {
+        if (tile_in_frustum(idx, v->view_tiles[t], cam))
+        {
+            v->view_tiles[n_tiles++] = v->view_tiles[t];
+        }
+    }
+    size_t n_cand = 0;
+
+    // Table fields in locals: the candidate stores below could alias them
+    const float h_visible = atm ? atm->h_visible : 0.0f;
+    const float h_min = atm ? atm->h_min : 0.0f;
+    const float inv_step = atm ? atm->inv_step : 0.0f;
+    const float *lift_a = atm ? atm->lift_a : NULL;
+    const float *lift_b = atm ? atm->lift_b : NULL;
+    const float *dmag = atm ? atm->dmag : NULL;
+
+    for (size_t t = 0; t < n_tiles; t++)
+    {
+        uint32_t tile = v->view_tiles[t];
+
+        for (uint32_t k = idx->tile_start[tile]; k < idx->tile_start[tile + 1]; k++)
+        {
+            uint32_t i = idx->order[k];
+
+            // Tile lists are in catalog order, i.e. brightest first
+            if (i >= n_bright)
+            {
+                break;
+            }
+
+            float ex = sc->ex[i], ey = sc->ey[i], ez = sc->ez[i];
+            float h = ex*zx + ey*zy + ez*zz;   // sin(altitude)
+            unsigned char rad;
+
+            if (!atm)
+            {
+                // below the horizon
+                if (h < 0.0f)
+                {
+                    continue;
+                }
+                rad = sc->rad[i];
+            }
+            else
+            {
+                // below the refracted horizon
+                if (h < h_visible)
+                {
+                    continue;
+                }
+
+                // Table blend, as atmos_lookup (h_visible > h_min, so f >= 0)
+                float f = (h - h_min) * inv_step;
+                int j = (int)f;
+                if (j >= ATMOS_TABLE)
+                {
+                    j = ATMOS_TABLE - 1;
+                }
+                float w = f - (float)j;
+
+                float mag = sc->mag[i] + dmag[j] + w * (dmag[j + 1] - dmag[j]);
+                if (mag > mag_limit)
+                {
+                    continue;
+                }
+
+                float la = lift_a[j] + w * (lift_a[j + 1] - lift_a[j]);
+                float lb = lift_b[j] + w * (lift_b[j + 1] - lift_b[j]);
+                ex = la*ex + lb*zx;
+                ey = la*ey + lb*zy;
+                ez = la*ez + lb*zz;
+                rad = (unsigned char)starcache_mag_to_radius(mag);
+            }
+
+            if (n_cand >= v->cand_cap)
+            {
+                break;
+            }
+
+            v->cand_x[n_cand] = ex;
+            v->cand_y[n_cand] = ey;
+            v->cand_z[n_cand] = ez;
+            v->cand_rad[n_cand] = rad;
+            n_cand++;
+        }
+    }
+
+    v->n_tiles = n_tiles;
+    v->n_cand = n_cand;
+    return n_cand;
+}
+
+size_t skyview_project(sky_view_t *v, const camera_t *cam)
+{
+    v->n_visible = astro_camera_project_batch(cam, v->cand_x, v->cand_y, v->cand_z, v->n_cand,
+                                              v->cand_xy, v->cand_vis);
+    return v->n_visible;
+}
+
+int skyview_draw(sky_view_t *v, SDL_Renderer *ren, SDL_Color color)
+{
+    if (!ren || !v->batch.atlas)
+    {
+        return -1;
+    }
+
+    // Whole star field in one geometry submission
+    starbatch_begin(&v->batch);
+
+    for (size_t j = 0; j < v->n_cand; j++)
+    {
+        if (!v->cand_vis[j])
+        {
+            continue;
+        }
+
+        starbatch_add(&v->batch, (int)v->cand_xy[2*j], (int)v->cand_xy[2*j + 1],
+                      (int)v->cand_rad[j], color);
+    }
+
+    return starbatch_flush(&v->batch, ren);
+}
+
+void skyview_free(sky_view_t *v)
+{
+    if (!v)
+    {
+        return;
+    }
+
+    free(v->cand_x);
+    free(v->cand_y);
+    free(v->cand_z);
+    free(v->cand_rad);
+    free(v->cand_xy);
+    free(v->cand_vis);
+    free(v->view_tiles);
+    starbatch_free(&v->batch);
+    memset(v, 0, sizeof(*v));
+}
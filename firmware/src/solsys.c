@@ -0,0 +1,382 @@
+#include "solsys.h"
+#include "astro.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEG2RAD_D(x) ((double)(x) * (M_PI / 180.0))
+
+#define AU_KM 149597870.7
+#define LIGHT_AU_PER_DAY 173.1446327
+
+// Mean obliquity at J2000, for ecliptic -> equatorial
+#define OBLIQUITY_J2000_DEG 23.4392911
+
+/*
+ * Keplerian elements at J2000 and their rates per Julian century,
+ * ecliptic and equinox of J2000 (Standish, "Approximate Positions of
+ * the Planets", table 1): a (AU), e, I, L, long. perihelion, long. node
+ * (degrees).
+ */
+typedef struct
+{
+    double a, e, i, l, peri, node;
+    double da, de, di, dl, dperi, dnode;
+} elements_t;
+
+static const elements_t EARTH =
+    { 1.00000261, 0.01671123, -0.00001531, 100.46457166, 102.93768193, 0.0,
+      0.00000562, -0.00004392, -0.01294668, 35999.37244981, 0.32327364, 0.0 };
+
+// Indexed by body - SOLSYS_MERCURY
+static const elements_t PLANETS[] = {
+    { 0.38709927, 0.20563593, 7.00497902, 252.25032350, 77.45779628, 48.33076593,
+      0.00000037, 0.00001906, -0.00594749, 149472.67411175, 0.16047689, -0.12534081 },
+    { 0.72333566, 0.00677672, 3.39467605, 181.97909950, 131.60246718, 76.67984255,
+      0.00000390, -0.00004107, -0.00078890, 58517.81538729, 0.00268329, -0.27769418 },
+    { 1.52371034, 0.09339410, 1.84969142, -4.55343205, -23.94362959, 49.55953891,
+      0.00001847, 0.00007882, -0.00813131, 19140.30268499, 0.44441088, -0.29257343 },
+    { 5.20288700, 0.04838624, 1.30439695, 34.39644051, 14.72847983, 100.47390909,
+      -0.00011607, -0.00013253, -0.00183714, 3034.74612775, 0.21252668, 0.20469106 },
+    { 9.53667594, 0.05386179, 2.48599187, 49.95424423, 92.59887831, 113.66242448,
+      -0.00125060, -0.00050991, 0.00193609, 1222.49362201, -0.41897216, -0.28867794 },
+    { 19.18916464, 0.04725744, 0.77263783, 313.23810451, 170.95427630, 74.01692503,
+      -0.00196176, -0.00004397, -0.00242939, 428.48202785, 0.40805281, 0.04240589 },
+    { 30.06992276, 0.00859048, 1.77004347, -55.12002969, 44.96476227, 131.78422574,
+      0.00026291, 0.00005105, 0.00035372, 218.45945325, -0.32241464, -0.00508664 },
+};
+
+/*
+ * Periodic terms of the Moon (Meeus, Astronomical Algorithms, tables
+ * 47.A and 47.B, all 60 of each): multiples of D, M, M', F and the
+ * amplitude in 1e-6 degree (longitude, latitude) or 1e-3 km (distance).
+ * Dropping the small ones is not free; the latitude terms below 0.002
+ * deg add up to ~20" (Meeus example 47.a).
+ */
+typedef struct
+{
+    signed char d, m, mp, f;
+    int sl, sr;
+} moon_lr_t;
+
+typedef struct
+{
+    signed char d, m, mp, f;
+    int sb;
+} moon_b_t;
+
+static const moon_lr_t MOON_LR[] = {
+    {0, 0, 1, 0, 6288774, -20905355}, {2, 0, -1, 0, 1274027, -3699111},
+    {2, 0, 0, 0, 658314, -2955968},   {0, 0, 2, 0, 213618, -569925},
+    {0, 1, 0, 0, -185116, 48888},     {0, 0, 0, 2, -114332, -3149},
+    {2, 0, -2, 0, 58793, 246158},     {2, -1, -1, 0, 57066, -152138},
+    {2, 0, 1, 0, 53322, -170733},     {2, -1, 0, 0, 45758, -204586},
+    {0, 1, -1, 0, -40923, -129620},   {1, 0, 0, 0, -34720, 108743},
+    {0, 1, 1, 0, -30383, 104755},     {2, 0, 0, -2, 15327, 10321},
+    {0, 0, 1, 2, -12528, 0},          {0, 0, 1, -2, 10980, 79661},
+    {4, 0, -1, 0, 10675, -34782},     {0, 0, 3, 0, 10034, -23210},
+    {4, 0, -2, 0, 8548, -21636},      {2, 1, -1, 0, -7888, 24208},
+    {2, 1, 0, 0, -6766, 30824},       {1, 0, -1, 0, -5163, -8379},
+    {1, 1, 0, 0, 4987, -16675},       {2, -1, 1, 0, 4036, -12831},
+    {2, 0, 2, 0, 3994, -10445},       {4, 0, 0, 0, 3861, -11650},
+    {2, 0, -3, 0, 3665, 14403},       {0, 1, -2, 0, -2689, -7003},
+    {2, 0, -1, 2, -2602, 0},          {2, -1, -2, 0, 2390, 10056},
+    {1, 0, 1, 0, -2348, 6322},        {2, -2, 0, 0, 2236, -9884},
+    {0, 1, 2, 0, -2120, 5751},        {0, 2, 0, 0, -2069, 0},
+    {2, -2, -1, 0, 2048, -4950},      {2, 0, 1, -2, -1773, 4130},
+    {2, 0, 0, 2, -1595, 0},           {4, -1, -1, 0, 1215, -3958},
+    {0, 0, 2, 2, -1110, 0},           {3, 0, -1, 0, -892, 3258},
+    {2, 1, 1, 0, -810, 2616},         {4, -1, -2, 0, 759, -1897},
+    {0, 2, -1, 0, -713, -2117},       {2, 2, -1, 0, -700, 2354},
+    {2, 1, -2, 0, 691, 0},            {2, -1, 0, -2, 596, 0},
+    {4, 0, 1, 0, 549, -1423},         {0, 0, 4, 0, 537, -1117},
+    {4, -1, 0, 0, 520, -1571},        {1, 0, -2, 0, -487, -1739},
+    {2, 1, 0, -2, -399, 0},           {0, 0, 2, -2, -381, -4421},
+    {1, 1, 1, 0, 351, 0},             {3, 0, -2, 0, -340, 0},
+    {4, 0, -3, 0, 330, 0},            {2, -1, 2, 0, 327, 0},
+    {0, 2, 1, 0, -323, 1165},         {1, 1, -1, 0, 299, 0},
+    {2, 0, 3, 0, 294, 0},             {2, 0, -1, -2, 0, 8752},
+};
+
+static const moon_b_t MOON_B[] = {
+    {0, 0, 0, 1, 5128122},   {0, 0, 1, 1, 280602},    {0, 0, 1, -1, 277693},
+    {2, 0, 0, -1, 173237},   {2, 0, -1, 1, 55413},    {2, 0, -1, -1, 46271},
+    {2, 0, 0, 1, 32573},     {0, 0, 2, 1, 17198},     {2, 0, 1, -1, 9266},
+    {0, 0, 2, -1, 8822},     {2, -1, 0, -1, 8216},    {2, 0, -2, -1, 4324},
+    {2, 0, 1, 1, 4200},      {2, 1, 0, -1, -3359},    {2, -1, -1, 1, 2463},
+    {2, -1, 0, 1, 2211},     {2, -1, -1, -1, 2065},   {0, 1, -1, -1, -1870},
+    {4, 0, -1, -1, 1828},    {0, 1, 0, 1, -1794},     {0, 0, 0, 3, -1749},
+    {0, 1, -1, 1, -1565},    {1, 0, 0, 1, -1491},     {0, 1, 1, 1, -1475},
+    {0, 1, 1, -1, -1410},    {0, 1, 0, -1, -1344},    {1, 0, 0, -1, -1335},
+    {0, 0, 3, 1, 1107},      {4, 0, 0, -1, 1021},     {4, 0, -1, 1, 833},
+    {0, 0, 1, -3, 777},      {4, 0, -2, 1, 671},      {2, 0, 0, -3, 607},
+    {2, 0, 2, -1, 596},      {2, -1, 1, -1, 491},     {2, 0, -2, 1, -451},
+    {0, 0, 3, -1, 439},      {2, 0, 2, 1, 422},       {2, 0, -3, -1, 421},
+    {2, 1, -1, 1, -366},     {2, 1, 0, 1, -351},      {4, 0, 0, 1, 331},
+    {2, -1, 1, 1, 315},      {2, -2, 0, -1, 302},     {0, 0, 1, 3, -283},
+    {2, 1, 1, -1, -229},     {1, 1, 0, -1, 223},      {1, 1, 0, 1, 223},
+    {0, 1, -2, -1, -220},    {2, 1, -1, -1, -220},    {1, 0, 1, 1, -185},
+    {2, -1, -2, -1, 181},    {0, 1, 2, 1, -177},      {4, 0, -2, -1, 176},
+    {4, -1, -1, -1, 166},    {1, 0, 1, -1, -164},     {4, 0, 1, -1, 132},
+    {1, 0, -1, -1, -119},    {4, -1, 0, -1, 115},     {2, -2, 0, 1, 107},
+};
+
+static const char *const NAMES[SOLSYS_BODY_COUNT] = {
+    "Sun", "Moon", "Mercury", "Venus", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune"
+};
+
+const char *solsys_name(solsys_body_t body)
+{
+    return (body >= 0 && body < SOLSYS_BODY_COUNT) ? NAMES[body] : "?";
+}
+
+// Heliocentric ecliptic J2000 position (AU), t in centuries of TT
+static void kepler_position(const elements_t *el, double t, double p[3])
+{
+    double a = el->a + el->da * t;
+    double e = el->e + el->de * t;
+    double inc = DEG2RAD_D(el->i + el->di * t);
+    double l = el->l + el->dl * t;
+    double peri = el->peri + el->dperi * t;
+    double node = DEG2RAD_D(el->node + el->dnode * t);
+
+    double w = DEG2RAD_D(peri) - node;
+    double m = DEG2RAD_D(fmod(l - peri, 360.0));
+
+    // Kepler's equation by Newton's method
+    double ea = m + e * sin(m);
+    for (int k = 0; k < 8; k++)
+    {
+        double d = (ea - e * sin(ea) - m) / (1.0 - e * cos(ea));
+        ea -= d;
+        if (fabs(d) < 1e-12)
+        {
+            break;
+        }
+    }
+
+    double xo = a * (cos(ea) - e);
+    double yo = a * sqrt(1.0 - e*e) * sin(ea);
+
+    double cw = cos(w), sw = sin(w);
+    double cn = cos(node), sn = sin(node);
+    double ci = cos(inc), si = sin(inc);
+
+    p[0] = (cw*cn - sw*sn*ci) * xo + (-sw*cn - cw*sn*ci) * yo;
+    p[1] = (cw*sn + sw*cn*ci) * xo + (-sw*sn + cw*cn*ci) * yo;
+    p[2] = (sw*si) * xo + (cw*si) * yo;
+}
+
+// Geocentric ecliptic J2000 position of the Moon (AU), t in centuries of TT
+static void moon_position(double t, double p[3])
+{
+    double lp = 218.3164477 + 481267.88123421 * t;
+    double d = DEG2RAD_D(297.8501921 + 445267.1114034 * t);
+    double m = DEG2RAD_D(357.5291092 + 35999.0502909 * t);
+    double mp = DEG2RAD_D(134.9633964 + 477198.8675055 * t);
+    double f = DEG2RAD_D(93.2720950 + 483202.0175233 * t);
+    double a1 = DEG2RAD_D(119.75 + 131.849 * t);
+    double a2 = DEG2RAD_D(53.09 + 479264.290 * t);
+    double a3 = DEG2RAD_D(313.45 + 481266.484 * t);
+    double e = 1.0 - (0.002516 + 0.0000074 * t) * t;
+    double lpr = DEG2RAD_D(lp);
+
+    double sl = 3958.0 * sin(a1) + 1962.0 * sin(lpr - f) + 318.0 * sin(a2);
+    double sr = 0.0;
+    for (size_t k = 0; k < sizeof(MOON_LR) / sizeof(MOON_LR[0]); k++)
+    {
+        const moon_lr_t *c = &MOON_LR[k];
+        double arg = c->d * d + c->m * m + c->mp * mp + c->f * f;
+        double ek = (c->m == 0) ? 1.0 : (abs(c->m) == 1 ? e : e*e);
+        sl += c->sl * ek * sin(arg);
+        sr += c->sr * ek * cos(arg);
+    }
+
+    double sb = -2235.0 * sin(lpr) + 382.0 * sin(a3) + 175.0 * sin(a1 - f) +
+                175.0 * sin(a1 + f) + 127.0 * sin(lpr - mp) - 115.0 * sin(lpr + mp);
+    for (size_t k = 0; k < sizeof(MOON_B) / sizeof(MOON_B[0]); k++)
+    {
+        const moon_b_t *c = &MOON_B[k];
+        double arg = c->d * d + c->m * m + c->mp * mp + c->f * f;
+        double ek = (c->m == 0) ? 1.0 : (abs(c->m) == 1 ? e : e*e);
+        sb += c->sb * ek * sin(arg);
+    }
+
+    // Mean equinox of date -> J2000 by the general precession in
+    // longitude (the ecliptic's own motion is a few arcseconds here)
+    double prec = (5029.0966 + 1.11113 * t) * t / 3600.0;
+    double lon = DEG2RAD_D(lp + sl * 1e-6 - prec);
+    double lat = DEG2RAD_D(sb * 1e-6);
+    double dist = (385000.56 + sr * 1e-3) / AU_KM;
+
+    p[0] = dist * cos(lat) * cos(lon);
+    p[1] = dist * cos(lat) * sin(lon);
+    p[2] = dist * sin(lat);
+}
+
+// Geocentric ecliptic J2000 position (AU) at TT centuries t
+static void ecliptic_position(solsys_body_t body, double t, double p[3])
+{
+    if (body == SOLSYS_MOON)
+    {
+        moon_position(t, p);
+        return;
+    }
+
+    double earth[3];
+    kepler_position(&EARTH, t, earth);
+
+    if (body == SOLSYS_SUN)
+    {
+        p[0] = -earth[0];
+        p[1] = -earth[1];
+        p[2] = -earth[2];
+        return;
+    }
+
+    // Planet where it was when the light left it (one iteration is
+    // plenty at these accuracies)
+    const elements_t *el = &PLANETS[body - SOLSYS_MERCURY];
+    double q[3];
+    kepler_position(el, t, q);
+
+    double dist = sqrt((q[0] - earth[0])*(q[0] - earth[0]) +
+                       (q[1] - earth[1])*(q[1] - earth[1]) +
+                       (q[2] - earth[2])*(q[2] - earth[2]));
+    kepler_position(el, t - dist / LIGHT_AU_PER_DAY / 36525.0, q);
+
+    p[0] = q[0] - earth[0];
+    p[1] = q[1] - earth[1];
+    p[2] = q[2] - earth[2];
+}
+
+// Geocentric equatorial-of-date position; m is astro_epoch_matrix near jd
+static void theory_position(solsys_body_t body, double jd_utc, const float m[9], double pos[3])
+{
+    double t = (jd_utc + SOLSYS_TT_MINUS_UTC_S / 86400.0 - ASTRO_JD_J2000) / 36525.0;
+
+    double p[3];
+    ecliptic_position(body, t, p);
+
+    // Ecliptic -> equatorial J2000
+    double eps = DEG2RAD_D(OBLIQUITY_J2000_DEG);
+    double ce = cos(eps), se = sin(eps);
+    double x = p[0];
+    double y = p[1] * ce - p[2] * se;
+    double z = p[1] * se + p[2] * ce;
+
+    // J2000 -> of date, as the star cache does
+    pos[0] = m[0]*x + m[1]*y + m[2]*z;
+    pos[1] = m[3]*x + m[4]*y + m[5]*z;
+    pos[2] = m[6]*x + m[7]*y + m[8]*z;
+}
+
+void solsys_theory_position(solsys_body_t body, double jd_utc, double pos[3])
+{
+    float m[9];
+    astro_epoch_matrix(jd_utc, m);
+    theory_position(body, jd_utc, m, pos);
+}
+
+void solsys_init(solsys_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->half_span = 0.5 * SOLSYS_SPAN_DAYS;
+}
+
+int solsys_update(solsys_t *s, double jd_utc)
+{
+    if (s->valid && fabs(jd_utc - s->t_mid) <= s->half_span)
+    {
+        return 0;
+    }
+
+    // Windows sit on a fixed grid, so each one is fit once whichever
+    // way time runs
+    s->half_span = 0.5 * SOLSYS_SPAN_DAYS;
+    s->t_mid = floor(jd_utc / SOLSYS_SPAN_DAYS) * SOLSYS_SPAN_DAYS + s->half_span;
+
+    // The frame rotation drifts ~0.1" a day; one matrix per window
+    float m[9];
+    astro_epoch_matrix(s->t_mid, m);
+
+    // Sample at the Chebyshev nodes; the coefficients follow from a
+    // discrete cosine transform of the samples
+    const int n = SOLSYS_CHEB_N;
+    double samples[SOLSYS_CHEB_N][3];
+
+    for (int b = 0; b < SOLSYS_BODY_COUNT; b++)
+    {
+        for (int k = 0; k < n; k++)
+        {
+            double x = cos(M_PI * (k + 0.5) / n);
+            theory_position((solsys_body_t)b, s->t_mid + s->half_span * x, m, samples[k]);
+        }
+
+        for (int c = 0; c < 3; c++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                double sum = 0.0;
+                for (int k = 0; k < n; k++)
+                {
+                    sum += samples[k][c] * cos(M_PI * j * (k + 0.5) / n);
+                }
+                s->coef[b][c][j] = (j == 0 ? 1.0 : 2.0) * sum / n;
+            }
+        }
+    }
+
+    s->valid = 1;
+    s->n_fits++;
+    return 1;
+}
+
+// Clenshaw sum of a Chebyshev series at x in [-1, 1]
+static double cheb_eval(const double *c, double x)
+{
+    double b1 = 0.0, b2 = 0.0;
+    double x2 = 2.0 * x;
+    for (int j = SOLSYS_CHEB_N - 1; j >= 1; j--)
+    {
+        double b0 = c[j] + x2 * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return c[0] + x * b1 - b2;
+}
+
+void solsys_position(const solsys_t *s, solsys_body_t body, double jd_utc, double pos[3])
+{
+    double x = (jd_utc - s->t_mid) / s->half_span;
+    for (int c = 0; c < 3; c++)
+    {
+        pos[c] = cheb_eval(s->coef[body][c], x);
+    }
+}
+
+void solsys_direction(const solsys_t *s, solsys_body_t body, double jd_utc,
+                      float zx, float zy, float zz, float *x, float *y, float *z)
+{
+    double p[3];
+    solsys_position(s, body, jd_utc, p);
+
+    // From the observer on the surface rather than the Earth's center;
+    // only the Moon moves noticeably (up to about 1 deg)
+    p[0] -= SOLSYS_EARTH_RADIUS_AU * zx;
+    p[1] -= SOLSYS_EARTH_RADIUS_AU * zy;
+    p[2] -= SOLSYS_EARTH_RADIUS_AU * zz;
+
+    double len = sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+    if (len <= 0.0)
+    {
+        len = 1.0;
+    }
+    *x = (float)(p[0] / len);
+    *y = (float)(p[1] / len);
+    *z = (float)(p[2] / len);
+}
@@ -0,0 +1,192 @@
+#include "starbatch.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Sprite for radius r is (2r + 3) px: the old (2r + 1) block plus a soft edge.
+// Radius 0 stays a single pixel like SDL_RenderDrawPoint.
+static int sprite_size(int r)
+{
+    return (r <= 0) ? 1 : 2*r + 3;
+}
+
+/*
+ * Renders the sprite coverage into the atlas pixels (RGBA32, white).
+ * Alpha is the disc coverage: solid inside radius r + 0.5, then a
+ * linear 1 px falloff.
+ */
+static void draw_sprite(Uint8 *pixels, int pitch, int x0, int r)
+{
+    int d = sprite_size(r);
+    float c = (float)(d - 1) * 0.5f;
+    float edge = (float)r + 0.5f;
+
+    for (int y = 0; y < d; y++)
+    {
+        for (int x = 0; x < d; x++)
+        {
+            float dx = (float)x - c;
+            float dy = (float)y - c;
+            float a = (r <= 0) ? 1.0f : edge + 1.0f - sqrtf(dx*dx + dy*dy);
+            if (a < 0.0f) a = 0.0f;
+            if (a > 1.0f) a = 1.0f;
+
+            Uint8 *p = pixels + y * pitch + (x0 + x) * 4;
+            p[0] = 255;
+            p[1] = 255;
+            p[2] = 255;
+            p[3] = (Uint8)(a * 255.0f + 0.5f);
+        }
+    }
+}
+
+int starbatch_init(star_batch_t *b, SDL_Renderer *ren)
+{
+    if (!b || !ren)
+    {
+        return -1;
+    }
+
+    memset(b, 0, sizeof(*b));
+
+    // Sprites side by side with a 1 px gap so filtering never bleeds
+    int atlas_w = 0, atlas_h = 0;
+    for (int r = 0; r < STARBATCH_SPRITES; r++)
+    {
+        atlas_w += sprite_size(r) + 1;
+        if (sprite_size(r) > atlas_h) atlas_h = sprite_size(r);
+    }
+
+    int pitch = atlas_w * 4;
+    Uint8 *pixels = (Uint8*)calloc((size_t)pitch * atlas_h, 1);
+    if (!pixels)
+    {
+        return -1;
+    }
+
+    int x0 = 0;
+    for (int r = 0; r < STARBATCH_SPRITES; r++)
+    {
+        int d = sprite_size(r);
+        draw_sprite(pixels, pitch, x0, r);
+
+        b->size[r] = d;
+        b->u0[r] = (float)x0 / (float)atlas_w;
+        b->u1[r] = (float)(x0 + d) / (float)atlas_w;
+        b->v0[r] = 0.0f;
+        b->v1[r] = (float)d / (float)atlas_h;
+        x0 += d + 1;
+    }
+
+    b->atlas = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                 atlas_w, atlas_h);
+    if (!b->atlas || SDL_UpdateTexture(b->atlas, NULL, pixels, pitch) != 0)
+    {
+        fprintf(stderr, "starbatch atlas: %s\n", SDL_GetError());
+        free(pixels);
+        starbatch_free(b);
+        return -1;
+    }
+    free(pixels);
+
+    SDL_SetTextureBlendMode(b->atlas, SDL_BLENDMODE_BLEND);
+    return 0;
+}
+
+void starbatch_begin(star_batch_t *b)
+{
+    b->count = 0;
+}
+
+static int grow(star_batch_t *b)
+{
+    size_t cap = b->cap ? b->cap * 2 : 1024;
+
+    SDL_Vertex *v = (SDL_Vertex*)realloc(b->verts, sizeof(SDL_Vertex) * 4 * cap);
+    if (!v)
+    {
+        return -1;
+    }
+    b->verts = v;
+
+    int *idx = (int*)realloc(b->indices, sizeof(int) * 6 * cap);
+    if (!idx)
+    {
+        return -1;
+    }
+    b->indices = idx;
+
+    // Two triangles per quad: (0 1 2) (2 1 3)
+    for (size_t q = b->cap; q < cap; q++)
+    {
+        int base = (int)(q * 4);
+        int *i6 = &b->indices[q * 6];
+        i6[0] = base;     i6[1] = base + 1; i6[2] = base + 2;
+        i6[3] = base + 2; i6[4] = base + 1; i6[5] = base + 3;
+    }
+
+    b->cap = cap;
+    return 0;
+}
+
+int starbatch_add(star_batch_t *b, int px, int py, int radius, SDL_Color color)
+{
+    if (b->count >= b->cap && grow(b) != 0)
+    {
+        return -1;
+    }
+
+    if (radius < 0) radius = 0;
+    if (radius >= STARBATCH_SPRITES) radius = STARBATCH_SPRITES - 1;
+
+    // Pixel-aligned quad centred on (px, py)
+    int d = b->size[radius];
+    float x0 = (float)(px - d / 2);
+    float y0 = (float)(py - d / 2);
+    float x1 = x0 + (float)d;
+    float y1 = y0 + (float)d;
+
+    SDL_Vertex *v = &b->verts[b->count * 4];
+    v[0].position.x = x0; v[0].position.y = y0;
+    v[1].position.x = x1; v[1].position.y = y0;
+    v[2].position.x = x0; v[2].position.y = y1;
+    v[3].position.x = x1; v[3].position.y = y1;
+
+    v[0].tex_coord.x = b->u0[radius]; v[0].tex_coord.y = b->v0[radius];
+    v[1].tex_coord.x = b->u1[radius]; v[1].tex_coord.y = b->v0[radius];
+    v[2].tex_coord.x = b->u0[radius]; v[2].tex_coord.y = b->v1[radius];
+    v[3].tex_coord.x = b->u1[radius]; v[3].tex_coord.y = b->v1[radius];
+
+    v[0].color = color;
+    v[1].color = color;
+    v[2].color = color;
+    v[3].color = color;
+
+    b->count++;
+    return 0;
+}
+
+int starbatch_flush(star_batch_t *b, SDL_Renderer *ren)
+{
+    if (b->count == 0)
+    {
+        return 0;
+    }
+
+    return SDL_RenderGeometry(ren, b->atlas, b->verts, (int)(b->count * 4),
+                              b->indices, (int)(b->count * 6));
+}
+
+void starbatch_free(star_batch_t *b)
+{
+    if (!b)
+    {
+        return;
+    }
+
+    if (b->atlas) SDL_DestroyTexture(b->atlas);
+    free(b->verts);
+    free(b->indices);
+    memset(b, 0, sizeof(*b));
+}
@@ -0,0 +1,257 @@
+#include "starcache.h"
+#include "astro.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int starcache_mag_to_radius(float mag)
+{
+    if (mag <= 1.0f)    // very bright
+    {
+        return 3;
+    }
+
+    if (mag <= 2.5f)    // bright
+    {
+        return 2;
+    }
+
+    if (mag <= 4.0f)    // medium
+    {
+        return 1;
+    }
+
+    return 0;           // faint
+}
+
+static void free_buf(star_cache_buf_t *b)
+{
+    free(b->ex);
+    free(b->ey);
+    free(b->ez);
+    free(b->rad);
+    free(b->mag);
+    skyindex_free(&b->index);
+    memset(b, 0, sizeof(*b));
+}
+
+/*
+ * Fills one buffer from the catalog. Runs on the worker thread only,
+ * on a buffer the render thread cannot see.
+ */
+static int build_buf(star_cache_buf_t *b, const star_catalog_t *cat, double epoch_jd)
+{
+    size_t n = cat->count;
+
+    if (b->count != n || !b->ex)
+    {
+        free_buf(b);
+
+        size_t alloc = n ? n : 1;
+        b->ex = (float*)malloc(sizeof(float) * alloc);
+        b->ey = (float*)malloc(sizeof(float) * alloc);
+        b->ez = (float*)malloc(sizeof(float) * alloc);
+        b->rad = (unsigned char*)malloc(sizeof(unsigned char) * alloc);
+        b->mag = (float*)malloc(sizeof(float) * alloc);
+
+        if (!b->ex || !b->ey || !b->ez || !b->rad || !b->mag)
+        {
+            free_buf(b);
+            return -1;
+        }
+        b->count = n;
+    }
+
+    // One matrix for the whole catalog; proper motion is per star
+    float m[9];
+    astro_epoch_matrix(epoch_jd, m);
+    double years = (epoch_jd - ASTRO_JD_J2000) / 365.25;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        float mag = cat->mag[i];
+        float x, y, z;
+        astro_radec_pm_to_unit(cat->ra_hours[i], cat->dec_deg[i],
+                               cat->pm_ra_mas[i], cat->pm_dec_mas[i], years, &x, &y, &z);
+
+        b->ex[i] = m[0]*x + m[1]*y + m[2]*z;
+        b->ey[i] = m[3]*x + m[4]*y + m[5]*z;
+        b->ez[i] = m[6]*x + m[7]*y + m[8]*z;
+        b->rad[i] = (unsigned char)starcache_mag_to_radius(mag);
+        b->mag[i] = mag;
+    }
+    b->epoch_jd = epoch_jd;
+
+    skyindex_free(&b->index);
+    if (skyindex_build(&b->index, b->ex, b->ey, b->ez, n, STARCACHE_INDEX_RES) != 0)
+    {
+        free_buf(b);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int worker_main(void *arg)
+{
+    star_cache_t *sc = (star_cache_t*)arg;
+
+    SDL_LockMutex(sc->lock);
+    for (;;)
+    {
+        while (!sc->pending && !sc->quit)
+        {
+            SDL_CondWait(sc->cond, sc->lock);
+        }
+
+        if (sc->quit)
+        {
+            break;
+        }
+
+        // Back buffer: never the published one, and not while the
+        // render thread still holds it from before the last swap.
+        int back = (sc->front == 0) ? 1 : 0;
+        while (sc->reading == back && !sc->quit)
+        {
+            SDL_CondWait(sc->cond, sc->lock);
+        }
+
+        if (sc->quit)
+        {
+            break;
+        }
+
+        sc->pending = 0;
+        sc->building = 1;
+        double epoch_jd = sc->epoch_jd;
+        SDL_UnlockMutex(sc->lock);
+
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        int rc = build_buf(&sc->bufs[back], sc->catalog, epoch_jd);
+        Uint64 t1 = SDL_GetPerformanceCounter();
+
+        SDL_LockMutex(sc->lock);
+        sc->building = 0;
+        if (rc == 0)
+        {
+            sc->bufs[back].build_ms = (float)((double)(t1 - t0) * 1000.0 /
+                                              (double)SDL_GetPerformanceFrequency());
+            sc->bufs[back].generation = ++sc->generation;
+            sc->front = back;
+        }
+        else
+        {
+            fprintf(stderr, "starcache: rebuild failed (out of memory)\n");
+        }
+    }
+    SDL_UnlockMutex(sc->lock);
+
+    return 0;
+}
+
+int starcache_start(star_cache_t *sc, const star_catalog_t *cat, double epoch_jd)
+{
+    if (!sc || !cat)
+    {
+        return -1;
+    }
+
+    memset(sc, 0, sizeof(*sc));
+    sc->catalog = cat;
+    sc->front = -1;
+    sc->reading = -1;
+    sc->pending = 1;    // first build
+    sc->epoch_jd = epoch_jd;
+
+    sc->lock = SDL_CreateMutex();
+    sc->cond = SDL_CreateCond();
+    if (!sc->lock || !sc->cond)
+    {
+        fprintf(stderr, "starcache: %s\n", SDL_GetError());
+        starcache_stop(sc);
+        return -1;
+    }
+
+    sc->thread = SDL_CreateThread(worker_main, "starcache", sc);
+    if (!sc->thread)
+    {
+        fprintf(stderr, "starcache: SDL_CreateThread %s\n", SDL_GetError());
+        starcache_stop(sc);
+        return -1;
+    }
+
+    return 0;
+}
+
+int starcache_set_epoch(star_cache_t *sc, double jd)
+{
+    int queued = 0;
+
+    SDL_LockMutex(sc->lock);
+    if (fabs(jd - sc->epoch_jd) > STARCACHE_EPOCH_DAYS)
+    {
+        sc->epoch_jd = jd;
+        sc->pending = 1;
+        SDL_CondSignal(sc->cond);
+        queued = 1;
+    }
+    SDL_UnlockMutex(sc->lock);
+
+    return queued;
+}
+
+int starcache_busy(star_cache_t *sc)
+{
+    SDL_LockMutex(sc->lock);
+    int busy = sc->pending || sc->building;
+    SDL_UnlockMutex(sc->lock);
+
+    return busy;
+}
+
+const star_cache_buf_t *starcache_acquire(star_cache_t *sc)
+{
+    SDL_LockMutex(sc->lock);
+    int idx = sc->front;
+    sc->reading = idx;
+    SDL_UnlockMutex(sc->lock);
+
+    return (idx >= 0) ? &sc->bufs[idx] : NULL;
+}
+
+void starcache_release(star_cache_t *sc)
+{
+    SDL_LockMutex(sc->lock);
+    sc->reading = -1;
+    SDL_CondSignal(sc->cond);   // worker may be waiting for this buffer
+    SDL_UnlockMutex(sc->lock);
+}
+
+void starcache_stop(star_cache_t *sc)
+{
+    if (!sc)
+    {
+        return;
+    }
+
+    if (sc->thread)
+    {
+        SDL_LockMutex(sc->lock);
+        sc->quit = 1;
+        SDL_CondSignal(sc->cond);
+        SDL_UnlockMutex(sc->lock);
+
+        SDL_WaitThread(sc->thread, NULL);
+        sc->thread = NULL;
+    }
+
+    free_buf(&sc->bufs[0]);
+    free_buf(&sc->bufs[1]);
+
+    if (sc->cond) SDL_DestroyCond(sc->cond);
+    if (sc->lock) SDL_DestroyMutex(sc->lock);
+    sc->cond = NULL;
+    sc->lock = NULL;
+}
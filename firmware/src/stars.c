@@ -2,6 +2,33 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+// Sort key: magnitude, then catalog index so ties order the same everywhere
+typedef struct
+{
+    float mag;
+    uint32_t idx;
+} mag_ref_t;
+
+static int cmp_mag(const void *a, const void *b)
+{
+    const mag_ref_t *ra = (const mag_ref_t*)a;
+    const mag_ref_t *rb = (const mag_ref_t*)b;
+    if (ra->mag != rb->mag)
+    {
+        return (ra->mag > rb->mag) - (ra->mag < rb->mag);
+    }
+    return (ra->idx > rb->idx) - (ra->idx < rb->idx);
+}
 
 static int is_comment_or_blank(const char *s)
 {
@@ -9,6 +36,86 @@ static int is_comment_or_blank(const char *s)
     return (*s == '\0' || *s == '\n' || *s == '#');
 }
 
+static size_t align_up(size_t n)
+{
+    return (n + STARS_BIN_ALIGN - 1) & ~(size_t)(STARS_BIN_ALIGN - 1);
+}
+
+static size_t section_size(int sec, size_t count, size_t names_size)
+{
+    if (sec == STARS_SEC_NAMES) return names_size;
+    if (sec == STARS_SEC_NAME_OFF) return count * sizeof(uint32_t);
+    return count * sizeof(float);
+}
+
+/*
+ * Places the sections one after another from start, each aligned.
+ * Heap catalogs and binary files share this layout; returns the end.
+ */
+static size_t layout(size_t start, size_t count, size_t names_size, uint64_t off[STARS_SEC_COUNT])
+{
+    size_t pos = start;
+    for (int k = 0; k < STARS_SEC_COUNT; k++)
+    {
+        pos = align_up(pos);
+        off[k] = pos;
+        pos += section_size(k, count, names_size);
+    }
+    return pos;
+}
+
+// Points the catalog arrays at the sections of base
+static void bind_sections(star_catalog_t *cat, char *base, const uint64_t off[STARS_SEC_COUNT])
+{
+    cat->ra_hours = (float*)(base + off[STARS_SEC_RA]);
+    cat->dec_deg = (float*)(base + off[STARS_SEC_DEC]);
+    cat->mag = (float*)(base + off[STARS_SEC_MAG]);
+    cat->pm_ra_mas = (float*)(base + off[STARS_SEC_PM_RA]);
+    cat->pm_dec_mas = (float*)(base + off[STARS_SEC_PM_DEC]);
+    cat->name_off = (uint32_t*)(base + off[STARS_SEC_NAME_OFF]);
+    cat->names = base + off[STARS_SEC_NAMES];
+}
+
+// One heap block for count stars and names_cap bytes of names.
+// names_size starts at 0; callers append names and bump it.
+static int alloc_catalog(star_catalog_t *cat, size_t count, size_t names_cap)
+{
+    memset(cat, 0, sizeof(*cat));
+    if (count > UINT32_MAX || names_cap > (size_t)UINT32_MAX + 1)
+    {
+        return -1;
+    }
+
+    uint64_t off[STARS_SEC_COUNT];
+    size_t size = layout(0, count, names_cap, off);
+
+    // malloc only promises 16 bytes; over-allocate and align the base
+    void *block = malloc(size + STARS_BIN_ALIGN);
+    if (!block)
+    {
+        return -1;
+    }
+
+    char *base = (char*)align_up((size_t)block);
+    bind_sections(cat, base, off);
+    cat->block = block;
+    cat->count = count;
+    return 0;
+}
+
+// Parses one CSV row; returns 1 if it holds a star.
+static int parse_csv_row(const char *line, char name[64], float v[5])
+{
+    if (is_comment_or_blank(line)) return 0;
+
+    // name, ra, dec, mag [, pm_ra, pm_dec]
+    v[0] = v[1] = v[2] = v[3] = v[4] = 0.f;
+
+    // crude CSV
+    int fields = sscanf(line, " %63[^, ],%f,%f,%f,%f,%f", name, &v[0], &v[1], &v[2], &v[3], &v[4]);
+    return fields == 4 || fields == 6;
+}
+
 int stars_load_csv(star_catalog_t *cat, const char *path)
 {
     if (!cat || !path)
@@ -16,8 +123,7 @@ int stars_load_csv(star_catalog_t *cat, const char *path)
         return -1;
     }
 
-    cat->items = NULL;
-    cat->count = 0;
+    memset(cat, 0, sizeof(*cat));
 
     FILE *fp = fopen(path, "r");
     if (!fp)
@@ -26,57 +132,443 @@ int stars_load_csv(star_catalog_t *cat, const char *path)
         return -1;
     }
 
-    size_t cap = 0;
     char line[256];
+    char name[64];
+    float v[5];
 
+    // First pass sizes the arrays and the name pool exactly
+    size_t count = 0, names_cap = 0;
     while (fgets(line, sizeof(line), fp))
     {
-        if (is_comment_or_blank(line)) continue;
+        if (parse_csv_row(line, name, v))
+        {
+            count++;
+            names_cap += strlen(name) + 1;
+        }
+    }
+
+    if (alloc_catalog(cat, count, names_cap) != 0)
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    rewind(fp);
+    size_t i = 0;
+    while (i < count && fgets(line, sizeof(line), fp))
+    {
+        if (!parse_csv_row(line, name, v)) continue;
+
+        size_t len = strlen(name) + 1;
+        if (len > names_cap - cat->names_size) break;
+
+        memcpy(cat->names + cat->names_size, name, len);
+        cat->name_off[i] = (uint32_t)cat->names_size;
+        cat->names_size += len;
+
+        cat->ra_hours[i] = v[0];
+        cat->dec_deg[i] = v[1];
+        cat->mag[i] = v[2];
+        cat->pm_ra_mas[i] = v[3];
+        cat->pm_dec_mas[i] = v[4];
+        i++;
+    }
+    fclose(fp);
+
+    // File changed between passes
+    cat->count = i;
+
+    return stars_sort_by_mag(cat);
+}
+
+/*
+ * Validates a binary catalog header against the mapped/read file size.
+ * Rejects files written on a host with a different byte order, since
+ * sections are used in place and never converted.
+ */
+static int check_bin_header(const stars_bin_header_t *hdr, const char *base, size_t file_size)
+{
+    if (hdr->magic != STARS_BIN_MAGIC)
+    {
+        fprintf(stderr, "stars bin: bad magic\n");
+        return -1;
+    }
+
+    if (hdr->endian != STARS_BIN_ENDIAN)
+    {
+        fprintf(stderr, "stars bin: written with a different byte order\n");
+        return -1;
+    }
 
-        // name, ra, dec, mag
-        char name[64];
-        float ra = 0.f, dec = 0.f, mag = 0.f;
+    if (hdr->version != STARS_BIN_VERSION ||
+        hdr->header_size != sizeof(stars_bin_header_t))
+    {
+        fprintf(stderr, "stars bin: unsupported version %u\n", (unsigned)hdr->version);
+        return -1;
+    }
+
+    // A flag this version does not define would be silently ignored
+    if (hdr->flags & ~STARS_BIN_FLAGS_KNOWN)
+    {
+        fprintf(stderr, "stars bin: unknown flags 0x%x\n", (unsigned)hdr->flags);
+        return -1;
+    }
 
-        // crude CSV
-        if (sscanf(line, " %63[^, ],%f,%f,%f", name, &ra, &dec, &mag) != 4)
+    // Bounding count and names_size by the file keeps the sizes below from overflowing
+    if (hdr->count > file_size / sizeof(float) || hdr->count > UINT32_MAX ||
+        hdr->names_size > file_size || hdr->names_size > (uint64_t)UINT32_MAX + 1)
+    {
+        fprintf(stderr, "stars bin: truncated file\n");
+        return -1;
+    }
+
+    for (int k = 0; k < STARS_SEC_COUNT; k++)
+    {
+        uint64_t off = hdr->offset[k];
+        size_t size = section_size(k, (size_t)hdr->count, (size_t)hdr->names_size);
+        if (off < sizeof(stars_bin_header_t) ||
+            off % sizeof(float) != 0 ||
+            off > file_size ||
+            size > file_size - off)
         {
-            continue;
+            fprintf(stderr, "stars bin: truncated file\n");
+            return -1;
         }
+    }
+
+    // Names are read up to their NUL; the pool must end with one
+    if (hdr->names_size > 0 && base[hdr->offset[STARS_SEC_NAMES] + hdr->names_size - 1] != '\0')
+    {
+        fprintf(stderr, "stars bin: unterminated name pool\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// Points cat at the sections of a checked file image
+static void bind_file(star_catalog_t *cat, void *map, size_t size)
+{
+    const stars_bin_header_t *hdr = (const stars_bin_header_t*)map;
+    bind_sections(cat, (char*)map, hdr->offset);
+    cat->map = map;
+    cat->map_size = size;
+    cat->count = (size_t)hdr->count;
+    cat->names_size = (size_t)hdr->names_size;
+    cat->mag_sorted = (hdr->flags & STARS_BIN_FLAG_MAG_SORTED) != 0;
+}
+
+int stars_load_bin(star_catalog_t *cat, const char *path)
+{
+    if (!cat || !path)
+    {
+        return -1;
+    }
 
-        if (cat->count >= cap)
+    memset(cat, 0, sizeof(*cat));
+
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        // A missing binary catalog is normal, callers fall back to CSV.
+        if (errno != ENOENT) perror("open stars bin");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(stars_bin_header_t))
+    {
+        close(fd);
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);      // mapping stays valid after close
+    if (map == MAP_FAILED)
+    {
+        perror("mmap stars bin");
+        return -1;
+    }
+
+    if (check_bin_header((const stars_bin_header_t*)map, (const char*)map, size) != 0)
+    {
+        munmap(map, size);
+        return -1;
+    }
+
+    // Pages are faulted in on first touch, so load time does not
+    // depend on catalog size, and names are never read unless used.
+    bind_file(cat, map, size);
+    return stars_sort_by_mag(cat);
+#else
+    // No mmap: read the whole file into one block and use it in place.
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+    {
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (len < (long)sizeof(stars_bin_header_t))
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    size_t size = (size_t)len;
+    void *map = malloc(size);
+    if (!map || fread(map, 1, size, fp) != size)
+    {
+        free(map);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    if (check_bin_header((const stars_bin_header_t*)map, (const char*)map, size) != 0)
+    {
+        free(map);
+        return -1;
+    }
+
+    bind_file(cat, map, size);
+    return stars_sort_by_mag(cat);
+#endif
+}
+
+int stars_save_bin(const star_catalog_t *cat, const char *path)
+{
+    if (!cat || !path)
+    {
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+    {
+        perror("fopen stars bin");
+        return -1;
+    }
+
+    stars_bin_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = STARS_BIN_MAGIC;
+    hdr.version = STARS_BIN_VERSION;
+    hdr.header_size = (uint16_t)sizeof(hdr);
+    hdr.endian = STARS_BIN_ENDIAN;
+    hdr.flags = cat->mag_sorted ? STARS_BIN_FLAG_MAG_SORTED : 0;
+    hdr.count = (uint64_t)cat->count;
+    hdr.names_size = (uint64_t)cat->names_size;
+    layout(sizeof(hdr), cat->count, cat->names_size, hdr.offset);
+
+    const void *data[STARS_SEC_COUNT] = {
+        cat->ra_hours, cat->dec_deg, cat->mag, cat->pm_ra_mas, cat->pm_dec_mas,
+        cat->name_off, cat->names
+    };
+
+    char pad[STARS_BIN_ALIGN];
+    memset(pad, 0, sizeof(pad));
+
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    size_t pos = sizeof(hdr);
+    for (int k = 0; k < STARS_SEC_COUNT && ok; k++)
+    {
+        size_t gap = (size_t)hdr.offset[k] - pos;
+        size_t size = section_size(k, cat->count, cat->names_size);
+        ok = fwrite(pad, 1, gap, fp) == gap &&
+             (size == 0 || fwrite(data[k], 1, size, fp) == size);
+        pos += gap + size;
+    }
+
+    if (fclose(fp) != 0 || !ok)
+    {
+        fprintf(stderr, "stars bin: write failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// xorshift32: small, and reproducible unlike rand()
+static float rand01(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+int stars_generate_synthetic(star_catalog_t *cat, size_t count, uint32_t seed)
+{
+    if (!cat)
+    {
+        return -1;
+    }
+
+    // Names are "SYN" plus at least seven digits
+    size_t names_cap = 0;
+    for (size_t i = 0, digits = 7, next = 10000000; i < count; i++)
+    {
+        if (i == next)
         {
-            size_t newcap = (cap == 0) ? 32 : cap * 2;
-            star_t *p = (star_t*)realloc(cat->items, newcap * sizeof(star_t));
-            if (!p)
-            {
-                fclose(fp);
-                stars_free(cat);
-                return -1;
-            }
-
-            cat->items = p;
-            cap = newcap;
+            digits++;
+            next *= 10;
         }
+        names_cap += 3 + digits + 1;
+    }
 
-        star_t *s = &cat->items[cat->count++];
-        memset(s, 0, sizeof(*s));
-        strncpy(s->name, name, sizeof(s->name) - 1);
-        s->ra_hours = ra;
-        s->dec_deg = dec;
-        s->mag = mag;
+    if (alloc_catalog(cat, count, names_cap) != 0)
+    {
+        return -1;
     }
 
-    fclose(fp);
+    uint32_t state = seed ? seed : 0x9E3779B9u;
+
+    // Star counts grow ~10^(0.45 m); the real sky has ~5000 stars to 6.5.
+    // Pick the faint limit that gives count stars and sample N(<m).
+    double m_max = 6.5 + log10((double)(count ? count : 1) / 5000.0) / 0.45;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        cat->name_off[i] = (uint32_t)cat->names_size;
+        cat->names_size += (size_t)snprintf(cat->names + cat->names_size,
+                                            names_cap - cat->names_size, "SYN%07zu", i) + 1;
+
+        // Uniform on the sphere: uniform RA, uniform sin(dec)
+        cat->ra_hours[i] = 24.0f * rand01(&state);
+        cat->dec_deg[i] = (float)(asin(2.0 * rand01(&state) - 1.0) * (180.0 / 3.14159265358979323846));
+
+        double u = rand01(&state) + 1e-7;
+        double m = m_max + log10(u) / 0.45;
+        cat->mag[i] = (float)(m < -1.5 ? -1.5 : m);
+        cat->pm_ra_mas[i] = 0.0f;
+        cat->pm_dec_mas[i] = 0.0f;
+    }
+
+    return stars_sort_by_mag(cat);
+}
+
+int stars_sort_by_mag(star_catalog_t *cat)
+{
+    if (!cat)
+    {
+        return -1;
+    }
+
+    if (cat->mag_sorted)
+    {
+        return 0;
+    }
+
+    if (cat->count > UINT32_MAX)
+    {
+        return -1;
+    }
+
+    mag_ref_t *refs = (mag_ref_t*)malloc(sizeof(mag_ref_t) * (cat->count ? cat->count : 1));
+    star_catalog_t out;
+    if (!refs || alloc_catalog(&out, cat->count, cat->names_size) != 0)
+    {
+        free(refs);
+        stars_free(cat);
+        return -1;
+    }
+
+    // Sort (mag, index) pairs, then gather every array through the
+    // permutation. Names stay where they are; only their offsets move.
+    for (size_t i = 0; i < cat->count; i++)
+    {
+        refs[i].mag = cat->mag[i];
+        refs[i].idx = (uint32_t)i;
+    }
+    if (cat->count > 1)
+    {
+        qsort(refs, cat->count, sizeof(mag_ref_t), cmp_mag);
+    }
+
+    for (size_t i = 0; i < cat->count; i++)
+    {
+        uint32_t j = refs[i].idx;
+        out.ra_hours[i] = cat->ra_hours[j];
+        out.dec_deg[i] = cat->dec_deg[j];
+        out.mag[i] = cat->mag[j];
+        out.pm_ra_mas[i] = cat->pm_ra_mas[j];
+        out.pm_dec_mas[i] = cat->pm_dec_mas[j];
+        out.name_off[i] = cat->name_off[j];
+    }
+    if (cat->names_size)
+    {
+        memcpy(out.names, cat->names, cat->names_size);
+    }
+    out.names_size = cat->names_size;
+    free(refs);
+
+    // Also drops the mapping of an unsorted file
+    stars_free(cat);
+    *cat = out;
+    cat->mag_sorted = 1;
     return 0;
 }
 
+size_t stars_mag_prefix(const star_catalog_t *cat, float mag_limit)
+{
+    if (!cat || !cat->mag_sorted)
+    {
+        return 0;
+    }
+
+    // First index with mag > mag_limit
+    size_t lo = 0, hi = cat->count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cat->mag[mid] <= mag_limit)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+const char *stars_name(const star_catalog_t *cat, size_t i)
+{
+    if (!cat || i >= cat->count || cat->name_off[i] >= cat->names_size)
+    {
+        return "";
+    }
+    return cat->names + cat->name_off[i];
+}
+
 void stars_free(star_catalog_t *cat)
 {
     if (!cat)
     {
         return;
     }
-    free(cat->items);
-    cat->items = NULL;
-    cat->count = 0;
-}
\ No newline at end of file
+
+    if (cat->map)
+    {
+#if !defined(_WIN32)
+        munmap(cat->map, cat->map_size);
+#else
+        free(cat->map);
+#endif
+    }
+    else
+    {
+        free(cat->block);
+    }
+
+    memset(cat, 0, sizeof(*cat));
+}
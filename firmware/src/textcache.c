@@ -0,0 +1,283 @@
+#include "textcache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GLYPH_BATCH (TEXTCACHE_MAX_KEY * 4)    // glyphs per geometry call
+
+// FNV-1a, only used to skip most string compares
+static uint32_t hash_str(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s)
+    {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int same_color(SDL_Color a, SDL_Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+int textcache_init(text_cache_t *tc, SDL_Renderer *ren, size_t capacity)
+{
+    if (!tc || !ren || capacity == 0)
+    {
+        return -1;
+    }
+
+    memset(tc, 0, sizeof(*tc));
+    tc->ren = ren;
+    tc->capacity = capacity;
+    tc->entries = (text_entry_t*)calloc(capacity, sizeof(text_entry_t));
+    if (!tc->entries)
+    {
+        return -1;
+    }
+
+    // Two triangles per glyph quad: (0 1 2) (2 1 3)
+    for (int q = 0; q < GLYPH_BATCH; q++)
+    {
+        int *i6 = &tc->indices[q * 6];
+        i6[0] = q*4;     i6[1] = q*4 + 1; i6[2] = q*4 + 2;
+        i6[3] = q*4 + 2; i6[4] = q*4 + 1; i6[5] = q*4 + 3;
+    }
+
+    return 0;
+}
+
+/*
+ * Rasterizes every printable ASCII glyph of a font into one strip.
+ * Glyph offsets come from the width of each prefix of that strip, so
+ * they line up with how TTF lays out the same characters.
+ */
+static glyph_atlas_t *get_atlas(text_cache_t *tc, TTF_Font *font)
+{
+    glyph_atlas_t *free_slot = NULL;
+
+    for (int i = 0; i < TEXTCACHE_MAX_FONTS; i++)
+    {
+        if (tc->atlases[i].font == font)
+        {
+            return tc->atlases[i].tex ? &tc->atlases[i] : NULL;
+        }
+        if (!tc->atlases[i].font && !free_slot)
+        {
+            free_slot = &tc->atlases[i];
+        }
+    }
+
+    if (!free_slot)
+    {
+        return NULL;
+    }
+
+    glyph_atlas_t *a = free_slot;
+    memset(a, 0, sizeof(*a));
+    a->font = font;     // remembered even on failure so we do not retry each frame
+
+    char strip[TEXTCACHE_GLYPH_COUNT + 1];
+    for (int i = 0; i < TEXTCACHE_GLYPH_COUNT; i++)
+    {
+        strip[i] = (char)(TEXTCACHE_GLYPH_FIRST + i);
+    }
+    strip[TEXTCACHE_GLYPH_COUNT] = '\0';
+
+    int prev = 0;
+    for (int i = 0; i < TEXTCACHE_GLYPH_COUNT; i++)
+    {
+        char saved = strip[i + 1];
+        strip[i + 1] = '\0';
+        int wpre = 0, hpre = 0;
+        TTF_SizeText(font, strip, &wpre, &hpre);
+        strip[i + 1] = saved;
+
+        a->x[i] = prev;
+        a->adv[i] = wpre - prev;
+        prev = wpre;
+    }
+
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *surf = TTF_RenderText_Solid(font, strip, white);
+    if (!surf)
+    {
+        return NULL;
+    }
+
+    a->tex = SDL_CreateTextureFromSurface(tc->ren, surf);
+    a->h = surf->h;
+    SDL_FreeSurface(surf);
+
+    return a->tex ? a : NULL;
+}
+
+void textcache_draw_glyphs(text_cache_t *tc, TTF_Font *font, const char *msg,
+                           SDL_Color color, int x, int y)
+{
+    if (!tc || !font || !msg)
+    {
+        return;
+    }
+
+    glyph_atlas_t *a = get_atlas(tc, font);
+    if (!a)
+    {
+        return;
+    }
+
+    int tw = 0, th = 0;
+    SDL_QueryTexture(a->tex, NULL, NULL, &tw, &th);
+    if (tw <= 0 || th <= 0)
+    {
+        return;
+    }
+
+    int n = 0;
+    float pen = (float)x;
+
+    for (const char *p = msg; ; p++)
+    {
+        if (*p == '\0' || n == GLYPH_BATCH)
+        {
+            if (n > 0)
+            {
+                SDL_RenderGeometry(tc->ren, a->tex, tc->verts, n * 4, tc->indices, n * 6);
+                n = 0;
+            }
+            if (*p == '\0')
+            {
+                break;
+            }
+        }
+
+        int g = (unsigned char)*p - TEXTCACHE_GLYPH_FIRST;
+        if (g < 0 || g >= TEXTCACHE_GLYPH_COUNT)
+        {
+            g = '?' - TEXTCACHE_GLYPH_FIRST;
+        }
+
+        float gw = (float)a->adv[g];
+        float u0 = (float)a->x[g] / (float)tw;
+        float u1 = (float)(a->x[g] + a->adv[g]) / (float)tw;
+
+        SDL_Vertex *v = &tc->verts[n * 4];
+        v[0].position.x = pen;      v[0].position.y = (float)y;
+        v[1].position.x = pen + gw; v[1].position.y = (float)y;
+        v[2].position.x = pen;      v[2].position.y = (float)(y + a->h);
+        v[3].position.x = pen + gw; v[3].position.y = (float)(y + a->h);
+
+        v[0].tex_coord.x = u0; v[0].tex_coord.y = 0.0f;
+        v[1].tex_coord.x = u1; v[1].tex_coord.y = 0.0f;
+        v[2].tex_coord.x = u0; v[2].tex_coord.y = 1.0f;
+        v[3].tex_coord.x = u1; v[3].tex_coord.y = 1.0f;
+
+        for (int k = 0; k < 4; k++)
+        {
+            v[k].color = color;
+        }
+
+        pen += gw;
+        n++;
+    }
+}
+
+void textcache_draw(text_cache_t *tc, TTF_Font *font, const char *msg,
+                    SDL_Color color, int x, int y)
+{
+    if (!tc || !font || !msg)
+    {
+        return;
+    }
+
+    if (strlen(msg) >= TEXTCACHE_MAX_KEY)
+    {
+        textcache_draw_glyphs(tc, font, msg, color, x, y);
+        return;
+    }
+
+    uint32_t h = hash_str(msg);
+    text_entry_t *hit = NULL;
+    text_entry_t *victim = &tc->entries[0];
+
+    for (size_t i = 0; i < tc->capacity; i++)
+    {
+        text_entry_t *e = &tc->entries[i];
+
+        if (e->tex && e->hash == h && e->font == font &&
+            same_color(e->color, color) && strcmp(e->text, msg) == 0)
+        {
+            hit = e;
+            break;
+        }
+
+        // Empty slot first, otherwise least recently used
+        if (!e->tex)
+        {
+            if (victim->tex) victim = e;
+        }
+        else if (victim->tex && e->last_used < victim->last_used)
+        {
+            victim = e;
+        }
+    }
+
+    if (!hit)
+    {
+        SDL_Surface *surf = TTF_RenderText_Solid(font, msg, color);
+        if (!surf)
+        {
+            return;
+        }
+
+        SDL_Texture *tex = SDL_CreateTextureFromSurface(tc->ren, surf);
+        if (!tex)
+        {
+            SDL_FreeSurface(surf);
+            return;
+        }
+
+        if (victim->tex) SDL_DestroyTexture(victim->tex);
+
+        hit = victim;
+        strcpy(hit->text, msg);
+        hit->hash = h;
+        hit->font = font;
+        hit->color = color;
+        hit->tex = tex;
+        hit->w = surf->w;
+        hit->h = surf->h;
+        SDL_FreeSurface(surf);
+    }
+
+    hit->last_used = ++tc->clock;
+
+    SDL_Rect dst = {x, y, hit->w, hit->h};
+    SDL_RenderCopy(tc->ren, hit->tex, NULL, &dst);
+}
+
+void textcache_free(text_cache_t *tc)
+{
+    if (!tc)
+    {
+        return;
+    }
+
+    if (tc->entries)
+    {
+        for (size_t i = 0; i < tc->capacity; i++)
+        {
+            if (tc->entries[i].tex) SDL_DestroyTexture(tc->entries[i].tex);
+        }
+        free(tc->entries);
+    }
+
+    for (int i = 0; i < TEXTCACHE_MAX_FONTS; i++)
+    {
+        if (tc->atlases[i].tex) SDL_DestroyTexture(tc->atlases[i].tex);
+    }
+
+    memset(tc, 0, sizeof(*tc));
+}
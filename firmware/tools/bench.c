@@ -0,0 +1,631 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <SDL.h>
+#include "imu.h"
+#include "stars.h"
+#include "astro.h"
+#include "orient.h"
+#include "fusion.h"
+#include "starcache.h"
+#include "skyview.h"
+#include "skycube.h"
+#include "grid.h"
+#include "constellations.h"
+#include "solsys.h"
+#include "atmos.h"
+#include "prof.h"
+
+/*
+ * Headless benchmark for the frame pipeline.
+ *
+ * Runs main.c's per-frame stages on a synthetic catalog: orientation
+ * through the fusion filter and its prediction (fed with sensor
+ * readings synthesized from the simulated motion, one filter step per
+ * frame where the app fuses on its sampler thread), camera basis,
+ * star cache and collect/project/draw. Rendering goes into an
+ * off-screen surface with SDL's software renderer (or nowhere with
+ * --null). --layers adds the other sky layers: all grid lines,
+ * stand-in constellation figures (see bench_figures) and the Sun,
+ * Moon and planets. Text (cardinal points, body labels, the overlay)
+ * needs SDL_ttf and a font and is not run. Prints one JSON object per
+ * catalog size so results from the Pi and x86 can be diffed or plotted.
+ * Stage statistics cover the last PROF_WINDOW frames of the run.
+ * --cube draws through the sky cube instead; its one-off face
+ * rendering is reported separately as cube_build_ms. --atmos
+ * applies refraction and extinction in the collect stage, as the app
+ * does by default. --warp R runs simulated time R times faster than
+ * the frame clock (negative runs backward), letting the cache
+ * re-propagate on its worker as the date moves, as the app's time
+ * warp does; epoch_rebuilds counts those.
+ *
+ * --ephem D skips the frame runs and checks the solar system cache
+ * instead: D days of one-day Chebyshev windows, each sampled between
+ * its fit nodes against the theory, reporting the fit time and the
+ * worst angular error per body.
+ *
+ * usage: pocket_planetarium_bench [--stars N[,N...]] [--frames F]
+ *                                 [--size WxH] [--fov DEG] [--mag M]
+ *                                 [--seed S] [--null] [--cube] [--atmos]
+ *                                 [--warp R] [--layers] [--ephem D]
+ */
+
+// Samples per window when checking the ephemeris fit
+#define BENCH_EPHEM_SAMPLES 97
+
+// Bright stars joined into stand-in figures; the real 88 constellations
+// come to about this many segments
+#define BENCH_FIGURE_STARS 700
+
+static double ticks_to_ms(Uint64 t)
+{
+    return (double)t * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+typedef struct
+{
+    int frames;
+    int w, h;
+    float fov;
+    float mag_cutoff;
+    uint32_t seed;
+    int null_render;
+    int cube;
+    int atmos;
+    double warp;
+    int layers;
+} bench_opts_t;
+
+/*
+ * Stand-in constellation figures: synthetic stars have no names to
+ * match the asset against, so each of the brightest stars is joined
+ * to its nearest bright neighbour. Short segments spread over the sky,
+ * culled and drawn by the same code as the real figures.
+ */
+static int bench_figures(constellations_t *c, const star_cache_buf_t *b)
+{
+    memset(c, 0, sizeof(*c));
+
+    size_t n = b->count < BENCH_FIGURE_STARS ? b->count : BENCH_FIGURE_STARS;
+    c->seg = (uint32_t*)malloc(sizeof(uint32_t) * 2 * (n ? n : 1));
+    if (!c->seg || linebatch_init(&c->batch, CONST_LINE_WIDTH) != 0)
+    {
+        constellations_free(c);
+        return -1;
+    }
+
+    for (size_t i = 0; i < n && n > 1; i++)
+    {
+        size_t best = (i == 0) ? 1 : 0;
+        float best_dot = -2.0f;
+        for (size_t j = 0; j < n; j++)
+        {
+            float d = b->ex[i]*b->ex[j] + b->ey[i]*b->ey[j] + b->ez[i]*b->ez[j];
+            if (j != i && d > best_dot)
+            {
+                best_dot = d;
+                best = j;
+            }
+        }
+
+        c->seg[2*c->n_seg] = (uint32_t)i;
+        c->seg[2*c->n_seg + 1] = (uint32_t)best;
+        c->n_seg++;
+    }
+    c->n_figures = 88;
+    return 0;
+}
+
+// Fit-vs-theory check of the solar system cache over `days` windows
+static int run_ephem(int days)
+{
+    const double jd0 = astro_julian_date_utc(2025, 1, 1, 3, 0, 0.0);
+    double worst[SOLSYS_BODY_COUNT] = {0};
+    Uint64 fit_ticks = 0;
+
+    solsys_t ss;
+    solsys_init(&ss);
+
+    for (int d = 0; d < days; d++)
+    {
+        // One window per day; the first sample of each day refits
+        for (int k = 0; k < BENCH_EPHEM_SAMPLES; k++)
+        {
+            double jd = jd0 + d + (k + 0.5) / BENCH_EPHEM_SAMPLES;
+
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            solsys_update(&ss, jd);
+            fit_ticks += SDL_GetPerformanceCounter() - t0;
+
+            for (int b = 0; b < SOLSYS_BODY_COUNT; b++)
+            {
+                double a[3], t[3];
+                solsys_position(&ss, (solsys_body_t)b, jd, a);
+                solsys_theory_position((solsys_body_t)b, jd, t);
+
+                // Angle between the two directions, stable for tiny angles
+                double cx = a[1]*t[2] - a[2]*t[1];
+                double cy = a[2]*t[0] - a[0]*t[2];
+                double cz = a[0]*t[1] - a[1]*t[0];
+                double dot = a[0]*t[0] + a[1]*t[1] + a[2]*t[2];
+                double err = atan2(sqrt(cx*cx + cy*cy + cz*cz), dot) * 180.0 / M_PI * 3600.0;
+                if (err > worst[b])
+                {
+                    worst[b] = err;
+                }
+            }
+        }
+    }
+
+    printf("{\"ephem_days\":%d,\"windows\":%u,\"cheb_terms\":%d,\"fit_ms\":%.4f,\"max_err_arcsec\":{",
+           days, ss.n_fits, SOLSYS_CHEB_N, ss.n_fits ? ticks_to_ms(fit_ticks) / ss.n_fits : 0.0);
+    for (int b = 0; b < SOLSYS_BODY_COUNT; b++)
+    {
+        printf("%s\"%s\":%.4f", b ? "," : "", solsys_name((solsys_body_t)b), worst[b]);
+    }
+    printf("}}\n");
+    fflush(stdout);
+    return 0;
+}
+
+// main.c's draw_bodies without the labels
+static void bench_bodies(const solsys_t *ss, double jd, const camera_t *cam_eq,
+                         float zx, float zy, float zz, const atmos_t *atm,
+                         star_batch_t *batch, SDL_Renderer *ren)
+{
+    const SDL_Color color = {255, 240, 200, 255};
+
+    starbatch_begin(batch);
+    for (int b = 0; b < SOLSYS_BODY_COUNT; b++)
+    {
+        float x, y, z;
+        solsys_direction(ss, (solsys_body_t)b, jd, zx, zy, zz, &x, &y, &z);
+
+        float h = x*zx + y*zy + z*zz;
+        if (h < (atm ? atm->h_visible : 0.0f))
+        {
+            continue;
+        }
+        if (atm)
+        {
+            float wa, wb, dmag;
+            atmos_lookup(atm, h, &wa, &wb, &dmag);
+            x = wa*x + wb*zx;
+            y = wa*y + wb*zy;
+            z = wa*z + wb*zz;
+        }
+
+        int px, py;
+        if (astro_camera_project(cam_eq, x, y, z, &px, &py, NULL))
+        {
+            starbatch_add(batch, px, py, 2, color);
+        }
+    }
+    starbatch_flush(batch, ren);
+}
+
+/*
+ * Sensor reading the simulated motion would produce: gyro from the
+ * attitude change over dt (body frame), accelerometer from gravity.
+ */
+static void synth_raw(quat_t q_prev, quat_t q, float dt, imu_raw_t *raw)
+{
+    // dq = conj(q_prev) * q ~ (1, w dt / 2)
+    quat_t qc = q_prev;
+    qc.x = -qc.x;
+    qc.y = -qc.y;
+    qc.z = -qc.z;
+    quat_t dq = orient_quat_mul(qc, q);
+    float s = (dq.w < 0.0f ? -2.0f : 2.0f) / dt * (180.0f / 3.14159265f);
+    raw->gx = dq.x * s;
+    raw->gy = dq.y * s;
+    raw->gz = dq.z * s;
+
+    // R^T * (0, 0, 1): up in the body frame, which a resting
+    // accelerometer reads as +1 g
+    raw->ax = 2.0f * (q.x*q.z - q.w*q.y);
+    raw->ay = 2.0f * (q.w*q.x + q.y*q.z);
+    raw->az = q.w*q.w - q.x*q.x - q.y*q.y + q.z*q.z;
+}
+
+static int run_one(size_t n_stars, const bench_opts_t *o)
+{
+    star_catalog_t catalog;
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    if (stars_generate_synthetic(&catalog, n_stars, o->seed) != 0)
+    {
+        fprintf(stderr, "bench: failed to generate %zu stars\n", n_stars);
+        return -1;
+    }
+    double gen_ms = ticks_to_ms(SDL_GetPerformanceCounter() - t0);
+
+    SDL_Surface *surf = NULL;
+    SDL_Renderer *ren = NULL;
+    if (!o->null_render)
+    {
+        surf = SDL_CreateRGBSurfaceWithFormat(0, o->w, o->h, 32, SDL_PIXELFORMAT_ARGB8888);
+        ren = surf ? SDL_CreateSoftwareRenderer(surf) : NULL;
+        if (!ren)
+        {
+            fprintf(stderr, "bench: software renderer: %s\n", SDL_GetError());
+            if (surf) SDL_FreeSurface(surf);
+            stars_free(&catalog);
+            return -1;
+        }
+    }
+
+    sky_view_t view;
+    star_cache_t cache;
+    if (skyview_init(&view, ren, catalog.count) != 0)
+    {
+        if (ren) SDL_DestroyRenderer(ren);
+        if (surf) SDL_FreeSurface(surf);
+        stars_free(&catalog);
+        return -1;
+    }
+
+    // Time the initial cache build (worker thread) end to end
+    const double jd = astro_julian_date_utc(2025, 1, 1, 3, 0, 0.0);
+    t0 = SDL_GetPerformanceCounter();
+    if (starcache_start(&cache, &catalog, jd) != 0)
+    {
+        skyview_free(&view);
+        if (ren) SDL_DestroyRenderer(ren);
+        if (surf) SDL_FreeSurface(surf);
+        stars_free(&catalog);
+        return -1;
+    }
+
+    for (;;)
+    {
+        const star_cache_buf_t *b = starcache_acquire(&cache);
+        starcache_release(&cache);
+        if (b) break;
+        SDL_Delay(1);
+    }
+    double cache_ms = ticks_to_ms(SDL_GetPerformanceCounter() - t0);
+
+    // Cube mode: render all six faces up front
+    sky_cube_t cube;
+    double cube_ms = 0.0;
+    const SDL_Color white = {255, 255, 255, 255};
+    size_t n_bright = stars_mag_prefix(&catalog, o->mag_cutoff);
+
+    atmos_t atm;
+    const atmos_t *use_atm = NULL;
+    if (o->atmos && atmos_init(&atm, ATMOS_DEFAULT_TEMP_C, ATMOS_DEFAULT_PRESSURE_HPA) == 0)
+    {
+        use_atm = &atm;
+    }
+    if (o->cube)
+    {
+        if (!ren || skycube_init(&cube, ren, 0, 0) != 0)
+        {
+            fprintf(stderr, "bench: sky cube needs a renderer with render targets\n");
+            starcache_stop(&cache);
+            skyview_free(&view);
+            if (ren) SDL_DestroyRenderer(ren);
+            if (surf) SDL_FreeSurface(surf);
+            stars_free(&catalog);
+            return -1;
+        }
+
+        t0 = SDL_GetPerformanceCounter();
+        const star_cache_buf_t *b = starcache_acquire(&cache);
+        while (skycube_update(&cube, ren, &view, b, n_bright, white, 0))
+        {
+        }
+        starcache_release(&cache);
+        cube_ms = ticks_to_ms(SDL_GetPerformanceCounter() - t0);
+    }
+
+    // Other sky layers, as main.c draws them
+    sky_grid_t grid;
+    constellations_t figures;
+    solsys_t solsys;
+    int layers = o->layers && ren;
+    if (layers)
+    {
+        const star_cache_buf_t *b = starcache_acquire(&cache);
+        int ok = grid_init(&grid) == 0;
+        if (ok && bench_figures(&figures, b) != 0)
+        {
+            grid_free(&grid);
+            ok = 0;
+        }
+        starcache_release(&cache);
+
+        if (!ok)
+        {
+            fprintf(stderr, "bench: failed to set up the sky layers\n");
+            if (o->cube) skycube_free(&cube);
+            starcache_stop(&cache);
+            skyview_free(&view);
+            if (ren) SDL_DestroyRenderer(ren);
+            if (surf) SDL_FreeSurface(surf);
+            stars_free(&catalog);
+            return -1;
+        }
+        solsys_init(&solsys);
+    }
+
+    camera_t cam, cam_eq;
+    astro_camera_init(&cam, o->w, o->h, o->fov);
+    const float dt = 1.0f / 60.0f;
+
+    profiler_t prof;
+    prof_init(&prof);
+    size_t sum_cand = 0, sum_visible = 0;
+    int epoch_rebuilds = 0;
+
+    // Same camera path for every catalog size
+    imu_data_t imu;
+    imu_sim_reset();
+    imu_sim_step(&imu, 0.0f);
+    quat_t q_sim = orient_quat_from_euler(imu.yaw, imu.pitch, imu.roll);
+
+    fusion_t fusion;
+    fusion_init(&fusion, FUSION_KP, FUSION_KI);
+
+    Uint64 run0 = SDL_GetPerformanceCounter();
+
+    for (int f = 0; f < o->frames; f++)
+    {
+        prof_frame_begin(&prof);
+
+        prof_begin(&prof, PROF_IMU);
+        imu_sim_step(&imu, dt);
+        quat_t q_prev = q_sim;
+        q_sim = orient_quat_from_euler(imu.yaw, imu.pitch, imu.roll);
+        imu_raw_t raw;
+        synth_raw(q_prev, q_sim, dt, &raw);
+        Uint64 sample_t = SDL_GetPerformanceCounter();
+        prof_end(&prof, PROF_IMU);
+
+        // Filter step (the app's sampler thread), then the render
+        // loop's extrapolation one frame ahead
+        prof_begin(&prof, PROF_ORIENT);
+        fusion_update(&fusion, &raw, dt);
+        float wx, wy, wz;
+        fusion_rate(&fusion, &raw, &wx, &wy, &wz);
+        quat_t q = fusion_predict(fusion.q, wx, wy, wz, dt);
+        prof_end(&prof, PROF_ORIENT);
+
+        prof_begin(&prof, PROF_CAMERA);
+        astro_camera_set_quat(&cam, q);
+
+        // Simulated time; a date far enough on re-propagates the cache
+        double jd_f = jd + f * (double)dt * o->warp / 86400.0;
+        if (starcache_set_epoch(&cache, jd_f))
+        {
+            epoch_rebuilds++;
+        }
+
+        float m[9];
+        astro_equatorial_to_local_matrix(jd_f, 32.7357, -97.1081, m);
+
+        astro_camera_rotated(&cam, m, &cam_eq);
+        if (layers)
+        {
+            solsys_update(&solsys, jd_f);
+        }
+        prof_end(&prof, PROF_CAMERA);
+
+        if (layers)
+        {
+            prof_begin(&prof, PROF_DRAW);
+            const SDL_Color line_color = {60, 90, 130, 255};
+            SDL_SetRenderDrawColor(ren, 10, 10, 40, 255);
+            SDL_RenderClear(ren);
+            grid_draw(&grid, ren, GRID_ALTAZ, &cam, 0.0f, 0.0f, 0.0f, line_color);
+            grid_draw(&grid, ren, GRID_RADEC, &cam_eq, m[6], m[7], m[8], line_color);
+            grid_draw(&grid, ren, GRID_EQUATOR, &cam_eq, m[6], m[7], m[8], line_color);
+            grid_draw(&grid, ren, GRID_HORIZON, &cam, 0.0f, 0.0f, 0.0f, line_color);
+            prof_end(&prof, PROF_DRAW);
+        }
+
+        // Held until the layers that read it are drawn
+        prof_begin(&prof, PROF_COLLECT);
+        const star_cache_buf_t *sc = starcache_acquire(&cache);
+        if (!o->cube)
+        {
+            skyview_collect(&view, sc, n_bright, &cam_eq, m[6], m[7], m[8],
+                            use_atm, o->mag_cutoff);
+        }
+        prof_end(&prof, PROF_COLLECT);
+
+        prof_begin(&prof, PROF_PROJECT);
+        if (!o->cube)
+        {
+            skyview_project(&view, &cam_eq);
+        }
+        prof_end(&prof, PROF_PROJECT);
+
+        prof_begin(&prof, PROF_DRAW);
+        if (ren)
+        {
+            if (layers)
+            {
+                const SDL_Color const_color = {70, 110, 160, 255};
+                constellations_draw(&figures, ren, sc, &cam_eq, m[6], m[7], m[8],
+                                    o->cube ? NULL : use_atm, const_color);
+            }
+            else
+            {
+                SDL_SetRenderDrawColor(ren, 10, 10, 40, 255);
+                SDL_RenderClear(ren);
+            }
+
+            if (o->cube)
+            {
+                skycube_draw(&cube, ren, &cam_eq, m[6], m[7], m[8]);
+            }
+            else
+            {
+                skyview_draw(&view, ren, white);
+            }
+
+            if (layers)
+            {
+                bench_bodies(&solsys, jd_f, &cam_eq, m[6], m[7], m[8], use_atm,
+                             &view.batch, ren);
+            }
+        }
+        starcache_release(&cache);
+        prof_end(&prof, PROF_DRAW);
+
+        prof_begin(&prof, PROF_PRESENT);
+        if (ren)
+        {
+            SDL_RenderPresent(ren);
+        }
+        prof_end(&prof, PROF_PRESENT);
+
+        // Sample -> present, as main.c measures motion-to-photon
+        prof_value(&prof, PROF_LATENCY, (float)ticks_to_ms(SDL_GetPerformanceCounter() - sample_t));
+
+        prof_frame_end(&prof);
+
+        sum_cand += view.n_cand;
+        sum_visible += view.n_visible;
+    }
+
+    double run_ms = ticks_to_ms(SDL_GetPerformanceCounter() - run0);
+    int frames = o->frames > 0 ? o->frames : 1;
+
+    printf("{\"stars\":%zu,\"bright\":%zu,\"frames\":%d,\"kernel\":\"%s\",\"renderer\":\"%s\","
+           "\"width\":%d,\"height\":%d,\"fov\":%.1f,\"mag_cutoff\":%.2f,\"cube\":%s,\"atmos\":%s,"
+           "\"layers\":%s,"
+           "\"warp\":%.0f,\"epoch_rebuilds\":%d,"
+           "\"generate_ms\":%.3f,\"cache_build_ms\":%.3f,\"cube_build_ms\":%.3f,"
+           "\"fps\":%.2f,\"frame_ms\":%.4f,\"candidates\":%.1f,\"visible\":%.1f,\"stages\":{",
+           catalog.count, n_bright, o->frames, astro_batch_impl(),
+           o->null_render ? "null" : "software",
+           o->w, o->h, o->fov, o->mag_cutoff, o->cube ? "true" : "false",
+           use_atm ? "true" : "false", layers ? "true" : "false", o->warp, epoch_rebuilds,
+           gen_ms, cache_ms, cube_ms,
+           run_ms > 0.0 ? o->frames * 1000.0 / run_ms : 0.0, run_ms / frames,
+           (double)sum_cand / frames, (double)sum_visible / frames);
+
+    for (int s = 0; s < PROF_STAGE_COUNT; s++)
+    {
+        prof_stats_t ps;
+        prof_stats(&prof, (prof_stage_t)s, &ps);
+        printf("%s\"%s\":{\"min_ms\":%.4f,\"avg_ms\":%.4f,\"p99_ms\":%.4f,\"max_ms\":%.4f}",
+               s ? "," : "", prof_stage_name((prof_stage_t)s),
+               ps.min_ms, ps.avg_ms, ps.p99_ms, ps.max_ms);
+    }
+    printf("}}\n");
+    fflush(stdout);
+
+    if (o->cube)
+    {
+        skycube_free(&cube);
+    }
+    if (layers)
+    {
+        constellations_free(&figures);
+        grid_free(&grid);
+    }
+    starcache_stop(&cache);
+    skyview_free(&view);
+    if (ren) SDL_DestroyRenderer(ren);
+    if (surf) SDL_FreeSurface(surf);
+    stars_free(&catalog);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    bench_opts_t o;
+    o.frames = 300;
+    o.w = 800;
+    o.h = 480;
+    o.fov = 70.0f;
+    o.mag_cutoff = 99.0f;   // whole catalog unless asked otherwise
+    o.seed = 1;
+    o.null_render = 0;
+    o.cube = 0;
+    o.atmos = 0;
+    o.warp = 1.0;
+    o.layers = 0;
+
+    const char *sizes = "1000,10000,100000,1000000";
+    int ephem_days = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *a = argv[i];
+        const char *next = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(a, "--null") == 0)
+        {
+            o.null_render = 1;
+        }
+        else if (strcmp(a, "--cube") == 0)
+        {
+            o.cube = 1;
+        }
+        else if (strcmp(a, "--atmos") == 0)
+        {
+            o.atmos = 1;
+        }
+        else if (strcmp(a, "--layers") == 0)
+        {
+            o.layers = 1;
+        }
+        else if (next && strcmp(a, "--stars") == 0)   { sizes = next; i++; }
+        else if (next && strcmp(a, "--frames") == 0)  { o.frames = atoi(next); i++; }
+        else if (next && strcmp(a, "--fov") == 0)     { o.fov = (float)atof(next); i++; }
+        else if (next && strcmp(a, "--mag") == 0)     { o.mag_cutoff = (float)atof(next); i++; }
+        else if (next && strcmp(a, "--warp") == 0)    { o.warp = atof(next); i++; }
+        else if (next && strcmp(a, "--ephem") == 0)   { ephem_days = atoi(next); i++; }
+        else if (next && strcmp(a, "--seed") == 0)    { o.seed = (uint32_t)strtoul(next, NULL, 10); i++; }
+        else if (next && strcmp(a, "--size") == 0 &&
+                 sscanf(next, "%dx%d", &o.w, &o.h) == 2)
+        {
+            i++;
+        }
+        else
+        {
+            fprintf(stderr,
+                    "usage: %s [--stars N[,N...]] [--frames F] [--size WxH] [--fov DEG]\n"
+                    "          [--mag M] [--seed S] [--null] [--cube] [--atmos]\n"
+                    "          [--warp R] [--layers] [--ephem D]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Threads and timers only; no window or video driver needed
+    if (SDL_Init(0) != 0)
+    {
+        fprintf(stderr, "SDL_Init %s\n", SDL_GetError());
+        return 1;
+    }
+
+    int rc = 0;
+    if (ephem_days > 0)
+    {
+        rc = run_ephem(ephem_days);
+        SDL_Quit();
+        return rc == 0 ? 0 : 1;
+    }
+
+    const char *p = sizes;
+    while (*p && rc == 0)
+    {
+        char *end = NULL;
+        unsigned long long n = strtoull(p, &end, 10);
+        if (end == p)
+        {
+            break;
+        }
+
+        rc = run_one((size_t)n, &o);
+        p = (*end == ',') ? end + 1 : end;
+    }
+
+    SDL_Quit();
+    return rc == 0 ? 0 : 1;
+}
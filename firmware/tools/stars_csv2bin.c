@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include "stars.h"
+
+/*
+ * Converts a CSV star catalog into the binary format read by
+ * stars_load_bin. The output uses the byte order of the host it
+ * was produced on, so run it on (or for) the target device.
+ *
+ * usage: stars_csv2bin <in.csv> <out.bin>
+ */
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <in.csv> <out.bin>\n", argv[0]);
+        return 1;
+    }
+
+    star_catalog_t cat;
+    if (stars_load_csv(&cat, argv[1]) != 0)
+    {
+        fprintf(stderr, "Failed to load %s\n", argv[1]);
+        return 1;
+    }
+
+    int rc = stars_save_bin(&cat, argv[2]);
+    if (rc == 0)
+    {
+        printf("Wrote %zu stars to %s\n", cat.count, argv[2]);
+    }
+
+    stars_free(&cat);
+    return rc == 0 ? 0 : 1;
+}